@@ -1,12 +1,50 @@
 #include <Python.h>
 #include <structmember.h>
 
+#include <thread>
+
 const float pi = 3.1415926535897932f;
 
+static int worker_count(long long work, long long grain) {
+    static const int hardware = std::thread::hardware_concurrency() ? (int)std::thread::hardware_concurrency() : 1;
+    const long long count = work / grain;
+    return count < 1 ? 1 : count > hardware ? hardware : count > 64 ? 64 : (int)count;
+}
+
+template <typename F>
+static void parallel_run(int workers, const F & fn) {
+    std::thread threads[64];
+    for (int i = 1; i < workers; ++i) {
+        try {
+            threads[i] = std::thread([&fn, i]() { fn(i); });
+        } catch (...) {
+            fn(i);
+        }
+    }
+    fn(0);
+    for (int i = 1; i < workers; ++i) {
+        if (threads[i].joinable()) {
+            threads[i].join();
+        }
+    }
+}
+
+template <typename F>
+static void parallel_for(int count, int grain, const F & fn) {
+    const int workers = worker_count(count, grain);
+    parallel_run(workers, [&](int worker) {
+        fn((int)((long long)count * worker / workers), (int)((long long)count * (worker + 1) / workers));
+    });
+}
+
 struct vec_t {
     float x, y, z;
 };
 
+struct dvec_t {
+    double x, y, z;
+};
+
 struct quat_t {
     float x, y, z, w;
 };
@@ -14,7 +52,7 @@ struct quat_t {
 struct trans_t {
     vec_t position;
     quat_t rotation;
-    float scale;
+    vec_t scale;
 };
 
 struct vert_t {
@@ -28,27 +66,47 @@ static inline vec_t normalize(const vec_t & v) {
     return {v.x * l, v.y * l, v.z * l};
 }
 
-static const trans_t identity = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f, 1.0f}, 1.0f};
+static const trans_t identity = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 1.0f}};
 
-static inline vec_t transform_vertex(const trans_t & t, const vec_t & v) {
-    const float tx = v.y * t.rotation.z - t.rotation.y * v.z - t.rotation.w * v.x;
-    const float ty = t.rotation.x * v.z - v.x * t.rotation.z - t.rotation.w * v.y;
-    const float tz = v.x * t.rotation.y - t.rotation.x * v.y - t.rotation.w * v.z;
+static inline bool uniform_scale(const vec_t & s) {
+    return s.x == s.y && s.y == s.z;
+}
+
+static inline vec_t rotate_vector(const quat_t & q, const vec_t & v) {
+    const float tx = v.y * q.z - q.y * v.z - q.w * v.x;
+    const float ty = q.x * v.z - v.x * q.z - q.w * v.y;
+    const float tz = v.x * q.y - q.x * v.y - q.w * v.z;
     return {
-      t.position.x + (v.x + (ty * t.rotation.z - t.rotation.y * tz) * 2.0f) * t.scale,
-      t.position.y + (v.y + (t.rotation.x * tz - tx * t.rotation.z) * 2.0f) * t.scale,
-      t.position.z + (v.z + (tx * t.rotation.y - t.rotation.x * ty) * 2.0f) * t.scale,
+      v.x + (ty * q.z - q.y * tz) * 2.0f,
+      v.y + (q.x * tz - tx * q.z) * 2.0f,
+      v.z + (tx * q.y - q.x * ty) * 2.0f,
     };
 }
 
+static inline vec_t transform_vertex(const trans_t & t, const vec_t & v) {
+    const vec_t & r = rotate_vector(t.rotation, {v.x * t.scale.x, v.y * t.scale.y, v.z * t.scale.z});
+    return {t.position.x + r.x, t.position.y + r.y, t.position.z + r.z};
+}
+
 static inline vec_t transform_normal(const trans_t & t, const vec_t & n) {
-    const float tx = n.y * t.rotation.z - t.rotation.y * n.z - t.rotation.w * n.x;
-    const float ty = t.rotation.x * n.z - n.x * t.rotation.z - t.rotation.w * n.y;
-    const float tz = n.x * t.rotation.y - t.rotation.x * n.y - t.rotation.w * n.z;
+    const vec_t & s = t.scale;
+    const float f = (s.x < 0.0f) ^ (s.y < 0.0f) ^ (s.z < 0.0f) ? -1.0f : 1.0f;
+    const vec_t c = {n.x * s.y * s.z * f, n.y * s.x * s.z * f, n.z * s.x * s.y * f};
+    if (c.x == 0.0f && c.y == 0.0f && c.z == 0.0f) {
+        return rotate_vector(t.rotation, {s.x < 0.0f ? -n.x : n.x, s.y < 0.0f ? -n.y : n.y, s.z < 0.0f ? -n.z : n.z});
+    }
+    return normalize(rotate_vector(t.rotation, c));
+}
+
+static inline dvec_t transform_position(const trans_t & t, const dvec_t & origin, const dvec_t & p) {
+    const dvec_t v = {p.x * t.scale.x, p.y * t.scale.y, p.z * t.scale.z};
+    const double tx = v.y * t.rotation.z - t.rotation.y * v.z - t.rotation.w * v.x;
+    const double ty = t.rotation.x * v.z - v.x * t.rotation.z - t.rotation.w * v.y;
+    const double tz = v.x * t.rotation.y - t.rotation.x * v.y - t.rotation.w * v.z;
     return {
-      n.x + (ty * t.rotation.z - t.rotation.y * tz) * 2.0f,
-      n.y + (t.rotation.x * tz - tx * t.rotation.z) * 2.0f,
-      n.z + (tx * t.rotation.y - t.rotation.x * ty) * 2.0f,
+      origin.x + v.x + (ty * t.rotation.z - t.rotation.y * tz) * 2.0,
+      origin.y + v.y + (t.rotation.x * tz - tx * t.rotation.z) * 2.0,
+      origin.z + v.z + (tx * t.rotation.y - t.rotation.x * ty) * 2.0,
     };
 }
 
@@ -65,11 +123,21 @@ static inline trans_t apply_transform(const trans_t & a, const trans_t & b) {
     return {
         transform_vertex(a, b.position),
         quatmul(a.rotation, b.rotation),
-        a.scale * b.scale,
+        {a.scale.x * b.scale.x, a.scale.y * b.scale.y, a.scale.z * b.scale.z},
     };
 }
 
 static inline vert_t apply_transform(const trans_t & a, const vert_t & b) {
+    const vec_t & n = rotate_vector(a.rotation, b.normal);
+    const float f = a.scale.x < 0.0f ? -1.0f : 1.0f;
+    return {
+        transform_vertex(a, b.vertex),
+        {n.x * f, n.y * f, n.z * f},
+        b.color,
+    };
+}
+
+static inline vert_t apply_scaled_transform(const trans_t & a, const vert_t & b) {
     return {
         transform_vertex(a, b.vertex),
         transform_normal(a, b.normal),
@@ -77,38 +145,381 @@ static inline vert_t apply_transform(const trans_t & a, const vert_t & b) {
     };
 }
 
+static inline bool degenerate(const vec_t & a, const vec_t & b, const vec_t & c) {
+    const vec_t u = {b.x - a.x, b.y - a.y, b.z - a.z};
+    const vec_t v = {c.x - a.x, c.y - a.y, c.z - a.z};
+    const vec_t n = {u.y * v.z - u.z * v.y, u.z * v.x - u.x * v.z, u.x * v.y - u.y * v.x};
+    const float uu = u.x * u.x + u.y * u.y + u.z * u.z;
+    const float vv = v.x * v.x + v.y * v.y + v.z * v.z;
+    return n.x * n.x + n.y * n.y + n.z * n.z <= 1e-12f * uu * vv;
+}
+
+static inline vec_t triangle_normal(const vec_t & a, const vec_t & b, const vec_t & c) {
+    const vec_t u = {b.x - a.x, b.y - a.y, b.z - a.z};
+    const vec_t v = {c.x - a.x, c.y - a.y, c.z - a.z};
+    return normalize({u.y * v.z - u.z * v.y, u.z * v.x - u.x * v.z, u.x * v.y - u.y * v.x});
+}
+
+static int strip_triangles(vert_t * vertex, vec_t * velocity, int count) {
+    int res = 0;
+    for (int i = 0; i + 2 < count; i += 3) {
+        if (degenerate(vertex[i].vertex, vertex[i + 1].vertex, vertex[i + 2].vertex)) {
+            continue;
+        }
+        if (res != i) {
+            memcpy(vertex + res, vertex + i, 3 * sizeof(vert_t));
+            if (velocity) {
+                memcpy(velocity + res, velocity + i, 3 * sizeof(vec_t));
+            }
+        }
+        res += 3;
+    }
+    return res;
+}
+
+struct baked_t {
+    trans_t transform;
+    int offset;
+    unsigned revision;
+};
+
+struct previous_t {
+    trans_t transform;
+    bool valid;
+};
+
+struct span_t {
+    int offset;
+    int size;
+};
+
+struct emitter_t {
+    int capacity;
+    int count;
+    float rate;
+    float lifetime;
+    float spawn;
+    float step;
+    vec_t velocity;
+    float spread;
+    float size[2];
+    vec_t color[2];
+    unsigned seed;
+    vec_t * position;
+    vec_t * speed;
+    float * age;
+};
+
+struct meshlet_t {
+    vec_t center;
+    float radius;
+    vec_t cone_axis;
+    float cone_cutoff;
+    int first_triangle;
+    int triangle_count;
+};
+
+struct geometry_t {
+    int refcount;
+    int meshlet_count;
+    meshlet_t * meshlet;
+    int cluster_count;
+    meshlet_t * cluster;
+    int strip_count;
+    int * strip;
+};
+
+struct plane_t {
+    vec_t normal;
+    float offset;
+};
+
+struct Scene;
+
 struct Mesh {
     PyObject_HEAD
+    Scene * scene;
     Mesh * parent;
     Mesh * slibling;
     Mesh * child;
+    PyObject * name;
+    PyObject * tags;
+    bool visible;
+    unsigned layers;
+    bool dynamic;
+    vec_t linear_velocity;
+    vec_t angular_velocity;
     trans_t local_transform;
     trans_t world_transform;
+    dvec_t position;
+    dvec_t world_position;
     int vertex_count;
     vert_t * vertex;
+    geometry_t * geometry;
+    emitter_t * emitter;
+    unsigned long long id;
+    unsigned revision;
+    int exports;
+    baked_t baked;
+    previous_t previous;
+};
+
+struct object_key_t {
+    Mesh * mesh;
+    unsigned long long id;
+    unsigned revision;
+};
+
+struct object_vert_t {
+    vert_t vert;
+    int node;
 };
 
 struct Scene {
     PyObject_HEAD
     Mesh * base;
+    PyObject * names;
+    PyObject * tags;
+    int node_count;
+    int node_capacity;
+    int * node_parent;
+    trans_t * node_local;
+    trans_t * node_world;
+    Mesh ** node_mesh;
+    baked_t * node_baked;
+    previous_t * node_previous;
+    PyObject * baked_object;
+    void * baked_buffer;
+    Py_ssize_t baked_size;
+    dvec_t previous_origin;
+    bool previous_valid;
+    unsigned structure;
+    unsigned order_structure;
+    int order_count;
+    Mesh ** order;
+    int level_count;
+    int * level;
+    unsigned transform_epoch;
+    PyObject * objects;
+    object_key_t * object_keys;
+    int object_count;
 };
 
 static PyTypeObject * Mesh_type;
 static PyTypeObject * Scene_type;
+static unsigned transform_epoch = 1;
+static unsigned long long mesh_id = 0;
 static PyObject * default_random_uniform;
 
-static Mesh * meth_empty(PyObject * self, PyObject * args, PyObject * kwargs) {
+static Mesh * new_mesh(int vertex_count) {
     Mesh * res = PyObject_New(Mesh, Mesh_type);
+    res->scene = NULL;
     res->parent = NULL;
     res->slibling = NULL;
     res->child = NULL;
+    res->name = Py_None;
+    Py_INCREF(Py_None);
+    res->tags = PyTuple_New(0);
+    res->visible = true;
+    res->layers = 1;
+    res->dynamic = false;
+    res->linear_velocity = {};
+    res->angular_velocity = {};
     res->local_transform = identity;
     res->world_transform = identity;
-    res->vertex_count = 0;
-    res->vertex = NULL;
+    res->position = {};
+    res->world_position = {};
+    res->vertex_count = vertex_count;
+    res->vertex = vertex_count ? (vert_t *)PyMem_Malloc(vertex_count * sizeof(vert_t)) : NULL;
+    res->geometry = NULL;
+    res->emitter = NULL;
+    res->id = ++mesh_id;
+    res->revision = 0;
+    res->exports = 0;
+    res->baked.offset = -1;
+    res->previous.valid = false;
+    return res;
+}
+
+static geometry_t * new_geometry() {
+    geometry_t * res = (geometry_t *)PyMem_Malloc(sizeof(geometry_t));
+    res->refcount = 1;
+    res->meshlet_count = 0;
+    res->meshlet = NULL;
+    res->cluster_count = 0;
+    res->cluster = NULL;
+    res->strip_count = -1;
+    res->strip = NULL;
+    return res;
+}
+
+static void clear_geometry(geometry_t * geometry) {
+    PyMem_Free(geometry->meshlet);
+    PyMem_Free(geometry->cluster);
+    PyMem_Free(geometry->strip);
+    geometry->meshlet_count = 0;
+    geometry->meshlet = NULL;
+    geometry->cluster_count = 0;
+    geometry->cluster = NULL;
+    geometry->strip_count = -1;
+    geometry->strip = NULL;
+}
+
+static void share_vertex(Mesh * src, Mesh * dst) {
+    if (src->exports) {
+        vert_t * vertex = (vert_t *)PyMem_Malloc(src->vertex_count * sizeof(vert_t) + sizeof(vert_t));
+        memcpy(vertex, src->vertex, src->vertex_count * sizeof(vert_t));
+        PyMem_Free(dst->vertex);
+        dst->vertex_count = src->vertex_count;
+        dst->vertex = vertex;
+        return;
+    }
+    if (!src->geometry) {
+        src->geometry = new_geometry();
+    }
+    src->geometry->refcount += 1;
+    PyMem_Free(dst->vertex);
+    dst->vertex_count = src->vertex_count;
+    dst->vertex = src->vertex;
+    dst->geometry = src->geometry;
+}
+
+static void * copy_memory(const void * data, int size) {
+    if (!data) {
+        return NULL;
+    }
+    void * res = PyMem_Malloc(size);
+    memcpy(res, data, size);
+    return res;
+}
+
+static geometry_t * copy_geometry(const geometry_t * src) {
+    geometry_t * res = new_geometry();
+    res->meshlet_count = src->meshlet_count;
+    res->meshlet = (meshlet_t *)copy_memory(src->meshlet, src->meshlet_count * sizeof(meshlet_t));
+    res->cluster_count = src->cluster_count;
+    res->cluster = (meshlet_t *)copy_memory(src->cluster, src->cluster_count * sizeof(meshlet_t));
+    res->strip_count = src->strip_count;
+    res->strip = (int *)copy_memory(src->strip, (src->strip_count > 0 ? src->strip_count : 0) * sizeof(int));
+    return res;
+}
+
+static void detach_vertex(Mesh * mesh, geometry_t * geometry) {
+    vert_t * vertex = (vert_t *)PyMem_Malloc(mesh->vertex_count * sizeof(vert_t));
+    memcpy(vertex, mesh->vertex, mesh->vertex_count * sizeof(vert_t));
+    mesh->geometry->refcount -= 1;
+    mesh->geometry = geometry;
+    mesh->vertex = vertex;
+}
+
+static void write_vertex(Mesh * mesh) {
+    mesh->revision += 1;
+    if (mesh->geometry && mesh->geometry->refcount > 1) {
+        detach_vertex(mesh, NULL);
+    } else if (mesh->geometry) {
+        clear_geometry(mesh->geometry);
+    }
+}
+
+static void own_vertex(Mesh * mesh) {
+    if (mesh->geometry && mesh->geometry->refcount > 1) {
+        detach_vertex(mesh, copy_geometry(mesh->geometry));
+    }
+}
+
+static void release_vertex(Mesh * mesh) {
+    if (mesh->geometry && --mesh->geometry->refcount) {
+        return;
+    }
+    if (mesh->geometry) {
+        clear_geometry(mesh->geometry);
+    }
+    PyMem_Free(mesh->geometry);
+    PyMem_Free(mesh->vertex);
+}
+
+static unsigned emitter_seed = 0x9e3779b9u;
+
+static emitter_t * new_emitter(int capacity) {
+    emitter_t * res = (emitter_t *)PyMem_Malloc(sizeof(emitter_t));
+    res->capacity = capacity;
+    res->count = 0;
+    res->spawn = 0.0f;
+    res->step = 0.0f;
+    emitter_seed = emitter_seed * 1664525u + 1013904223u;
+    res->seed = emitter_seed | 1;
+    res->position = (vec_t *)PyMem_Malloc(capacity * sizeof(vec_t));
+    res->speed = (vec_t *)PyMem_Malloc(capacity * sizeof(vec_t));
+    res->age = (float *)PyMem_Malloc(capacity * sizeof(float));
     return res;
 }
 
+static void release_emitter(emitter_t * emitter) {
+    if (emitter) {
+        PyMem_Free(emitter->position);
+        PyMem_Free(emitter->speed);
+        PyMem_Free(emitter->age);
+        PyMem_Free(emitter);
+    }
+}
+
+static inline float random_signed(unsigned & seed) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return (float)(seed >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+static void step_emitter(emitter_t * emitter, float dt, const vec_t & gravity) {
+    int alive = 0;
+    while (alive < emitter->count) {
+        emitter->age[alive] += dt;
+        if (emitter->age[alive] >= emitter->lifetime) {
+            const int last = --emitter->count;
+            emitter->position[alive] = emitter->position[last];
+            emitter->speed[alive] = emitter->speed[last];
+            emitter->age[alive] = emitter->age[last];
+            continue;
+        }
+        ++alive;
+    }
+
+    const int count = emitter->count;
+    vec_t * position = emitter->position;
+    vec_t * speed = emitter->speed;
+    for (int i = 0; i < count; ++i) {
+        speed[i] = {speed[i].x + gravity.x * dt, speed[i].y + gravity.y * dt, speed[i].z + gravity.z * dt};
+        position[i] = {position[i].x + speed[i].x * dt, position[i].y + speed[i].y * dt, position[i].z + speed[i].z * dt};
+    }
+
+    emitter->spawn += emitter->rate * dt;
+    while (emitter->spawn >= 1.0f && emitter->count < emitter->capacity) {
+        const int index = emitter->count++;
+        const vec_t & v = emitter->velocity;
+        const float spread = emitter->spread;
+        emitter->position[index] = {0.0f, 0.0f, 0.0f};
+        emitter->speed[index] = {
+            v.x + random_signed(emitter->seed) * spread,
+            v.y + random_signed(emitter->seed) * spread,
+            v.z + random_signed(emitter->seed) * spread,
+        };
+        emitter->age[index] = 0.0f;
+        emitter->spawn -= 1.0f;
+    }
+    if (emitter->spawn > 1.0f) {
+        emitter->spawn = 1.0f;
+    }
+    emitter->step = dt;
+}
+
+static inline int emitted_vertex_count(const Mesh * mesh) {
+    return mesh->emitter ? mesh->emitter->count * mesh->vertex_count : mesh->vertex_count;
+}
+
+static Mesh * meth_empty(PyObject * self, PyObject * args, PyObject * kwargs) {
+    return new_mesh(0);
+}
+
 static Mesh * meth_plane(PyObject * self, PyObject * args, PyObject * kwargs) {
     const char * keywords[] = {"width", "length", "color", NULL};
 
@@ -122,14 +533,7 @@ static Mesh * meth_plane(PyObject * self, PyObject * args, PyObject * kwargs) {
     const float sx = width * 0.5f;
     const float sy = length * 0.5f;
 
-    Mesh * res = PyObject_New(Mesh, Mesh_type);
-    res->parent = NULL;
-    res->slibling = NULL;
-    res->child = NULL;
-    res->local_transform = identity;
-    res->world_transform = identity;
-    res->vertex_count = 6;
-    res->vertex = (vert_t *)PyMem_Malloc(res->vertex_count * sizeof(vert_t));
+    Mesh * res = new_mesh(6);
     res->vertex[0] = {{-sx, -sy, 0.0f}, {0.0f, 0.0f, 1.0f}, color};
     res->vertex[1] = {{sx, -sy, 0.0f}, {0.0f, 0.0f, 1.0f}, color};
     res->vertex[2] = {{sx, sy, 0.0f}, {0.0f, 0.0f, 1.0f}, color};
@@ -153,14 +557,7 @@ static Mesh * meth_box(PyObject * self, PyObject * args, PyObject * kwargs) {
     const float sy = length * 0.5f;
     const float sz = height * 0.5f;
 
-    Mesh * res = PyObject_New(Mesh, Mesh_type);
-    res->parent = NULL;
-    res->slibling = NULL;
-    res->child = NULL;
-    res->local_transform = identity;
-    res->world_transform = identity;
-    res->vertex_count = 36;
-    res->vertex = (vert_t *)PyMem_Malloc(res->vertex_count * sizeof(vert_t));
+    Mesh * res = new_mesh(36);
     res->vertex[0] = {{-sx, -sy, -sz}, {0.0f, 0.0f, -1.0f}, color};
     res->vertex[1] = {{-sx, sy, -sz}, {0.0f, 0.0f, -1.0f}, color};
     res->vertex[2] = {{sx, sy, -sz}, {0.0f, 0.0f, -1.0f}, color};
@@ -211,14 +608,7 @@ static Mesh * meth_cylinder(PyObject * self, PyObject * args, PyObject * kwargs)
         return NULL;
     }
 
-    Mesh * res = PyObject_New(Mesh, Mesh_type);
-    res->parent = NULL;
-    res->slibling = NULL;
-    res->child = NULL;
-    res->local_transform = identity;
-    res->world_transform = identity;
-    res->vertex_count = resolution * 12;
-    res->vertex = (vert_t *)PyMem_Malloc(res->vertex_count * sizeof(vert_t));
+    Mesh * res = new_mesh(resolution * 12);
     vert_t * ptr = res->vertex;
 
     const float top = height * 0.5f;
@@ -263,14 +653,7 @@ static Mesh * meth_uvsphere(PyObject * self, PyObject * args, PyObject * kwargs)
 
     int half_resolution = resolution / 2;
 
-    Mesh * res = PyObject_New(Mesh, Mesh_type);
-    res->parent = NULL;
-    res->slibling = NULL;
-    res->child = NULL;
-    res->local_transform = identity;
-    res->world_transform = identity;
-    res->vertex_count = resolution * (half_resolution - 1) * 12;
-    res->vertex = (vert_t *)PyMem_Malloc(res->vertex_count * sizeof(vert_t));
+    Mesh * res = new_mesh(resolution * (half_resolution - 1) * 12);
     vert_t * ptr = res->vertex;
 
     for (int i = 0; i < half_resolution; ++i) {
@@ -316,14 +699,7 @@ static Mesh * meth_icosphere(PyObject * self, PyObject * args, PyObject * kwargs
 
     resolution = resolution < 1 ? 1 : resolution > 8 ? 8 : resolution;
 
-    Mesh * res = PyObject_New(Mesh, Mesh_type);
-    res->parent = NULL;
-    res->slibling = NULL;
-    res->child = NULL;
-    res->local_transform = identity;
-    res->world_transform = identity;
-    res->vertex_count = 60 * (1 << ((resolution - 1) * 2));
-    res->vertex = (vert_t *)PyMem_Malloc(res->vertex_count * sizeof(vert_t));
+    Mesh * res = new_mesh(60 * (1 << ((resolution - 1) * 2)));
     vert_t * ptr = res->vertex + res->vertex_count - 60;
 
     for (int i = 0; i < 5; ++i) {
@@ -396,20 +772,62 @@ static Mesh * meth_mesh(PyObject * self, PyObject * args, PyObject * kwargs) {
         return NULL;
     }
 
-    Mesh * res = PyObject_New(Mesh, Mesh_type);
-    res->parent = NULL;
-    res->slibling = NULL;
-    res->child = NULL;
-    res->local_transform = identity;
-    res->world_transform = identity;
-    res->vertex_count = (int)(view.len / sizeof(vert_t));
-    res->vertex = (vert_t *)PyMem_Malloc(res->vertex_count * sizeof(vert_t));
+    Mesh * res = new_mesh((int)(view.len / sizeof(vert_t)));
     memcpy(res->vertex, view.buf, view.len);
 
     PyBuffer_Release(&view);
     return res;
 }
 
+static Mesh * meth_emitter(PyObject * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"mesh", "rate", "lifetime", "velocity", "spread", "size", "color", "capacity", NULL};
+
+    Mesh * mesh;
+    float rate = 100.0f;
+    float lifetime = 1.0f;
+    vec_t velocity = {0.0f, 0.0f, 1.0f};
+    float spread = 0.5f;
+    float size[2] = {1.0f, 1.0f};
+    vec_t color[2] = {{1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f}};
+    int capacity = -1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|ff(fff)f(ff)((fff)(fff))i", (char **)keywords, Mesh_type, &mesh, &rate, &lifetime, &velocity.x, &velocity.y, &velocity.z, &spread, &size[0], &size[1], &color[0].x, &color[0].y, &color[0].z, &color[1].x, &color[1].y, &color[1].z, &capacity)) {
+        return NULL;
+    }
+
+    if (!(lifetime > 0.0f)) {
+        PyErr_Format(PyExc_ValueError, "lifetime must be positive");
+        return NULL;
+    }
+
+    if (!(rate >= 0.0f)) {
+        PyErr_Format(PyExc_ValueError, "rate must not be negative");
+        return NULL;
+    }
+
+    if (capacity < 0) {
+        const float estimate = ceilf(rate * lifetime);
+        if (!(estimate < 268435456.0f)) {
+            PyErr_Format(PyExc_ValueError, "rate * lifetime is too large, pass an explicit capacity");
+            return NULL;
+        }
+        capacity = (int)estimate + 1;
+    }
+
+    Mesh * res = new_mesh(0);
+    share_vertex(mesh, res);
+    res->emitter = new_emitter(capacity);
+    res->emitter->rate = rate;
+    res->emitter->lifetime = lifetime;
+    res->emitter->velocity = velocity;
+    res->emitter->spread = spread;
+    res->emitter->size[0] = size[0];
+    res->emitter->size[1] = size[1];
+    res->emitter->color[0] = color[0];
+    res->emitter->color[1] = color[1];
+    return res;
+}
+
 static inline float random_float(PyObject * uniform) {
     PyObject * res = PyObject_CallFunction(uniform, NULL);
     float x = (float)PyFloat_AsDouble(res);
@@ -463,130 +881,3145 @@ static PyObject * meth_euler(PyObject * self, PyObject * args, PyObject * kwargs
     return Py_BuildValue("(ffff)", q.x, q.y, q.z, q.w);
 }
 
-static Scene * meth_scene(PyObject * self, PyObject * args, PyObject * kwargs) {
-    Scene * res = PyObject_New(Scene, Scene_type);
-    res->base = PyObject_New(Mesh, Mesh_type);
-    res->base->parent = NULL;
-    res->base->slibling = NULL;
-    res->base->child = NULL;
-    res->base->local_transform = identity;
-    res->base->world_transform = identity;
-    res->base->vertex_count = 0;
-    res->base->vertex = NULL;
-    return res;
+static int broadcast_count(Py_buffer & a, int a_size, Py_buffer & b, int b_size) {
+    const int a_count = (int)(a.len / a_size);
+    const int b_count = (int)(b.len / b_size);
+    if (a.len % a_size || b.len % b_size || (a_count != b_count && a_count != 1 && b_count != 1)) {
+        PyErr_Format(PyExc_ValueError, "buffer sizes do not match");
+        PyBuffer_Release(&a);
+        PyBuffer_Release(&b);
+        return -1;
+    }
+    return a_count == 1 ? b_count : a_count;
 }
 
-static PyObject * Mesh_meth_add(Mesh * self, PyObject * args, PyObject * kwargs) {
-    const char * keywords[] = {"mesh", NULL};
+template <typename R, typename A, typename B, typename F>
+static void broadcast_map(R * res, const A * a, bool a_single, const B * b, bool b_single, int count, const F & fn) {
+    if (a_single) {
+        const A x = *a;
+        for (int i = 0; i < count; ++i) {
+            res[i] = fn(x, b[i]);
+        }
+    } else if (b_single) {
+        const B y = *b;
+        for (int i = 0; i < count; ++i) {
+            res[i] = fn(a[i], y);
+        }
+    } else {
+        for (int i = 0; i < count; ++i) {
+            res[i] = fn(a[i], b[i]);
+        }
+    }
+}
 
-    Mesh * mesh;
+static PyObject * meth_quat_mul(PyObject * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"a", "b", NULL};
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!", (char **)keywords, Mesh_type, &mesh)) {
+    Py_buffer a = {};
+    Py_buffer b = {};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*y*", (char **)keywords, &a, &b)) {
         return NULL;
     }
 
-    Py_INCREF(mesh);
-    mesh->parent = self;
-    mesh->slibling = self->child;
-    self->child = mesh;
-    Py_RETURN_NONE;
+    const int count = broadcast_count(a, sizeof(quat_t), b, sizeof(quat_t));
+    if (count < 0) {
+        return NULL;
+    }
+
+    PyObject * res = PyBytes_FromStringAndSize(NULL, count * sizeof(quat_t));
+    quat_t * ptr = (quat_t *)PyBytes_AsString(res);
+    const quat_t * qa = (quat_t *)a.buf;
+    const quat_t * qb = (quat_t *)b.buf;
+    broadcast_map(ptr, qa, a.len == sizeof(quat_t), qb, b.len == sizeof(quat_t), count, [](const quat_t & x, const quat_t & y) {
+        return quatmul(x, y);
+    });
+
+    PyBuffer_Release(&a);
+    PyBuffer_Release(&b);
+    return res;
 }
 
-static PyObject * Mesh_meth_paint(Mesh * self, PyObject * args, PyObject * kwargs) {
-    const char * keywords[] = {"color", NULL};
+static PyObject * meth_quat_rotate(PyObject * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"rotation", "vectors", NULL};
 
-    vec_t color;
+    Py_buffer a = {};
+    Py_buffer b = {};
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "fff", (char **)keywords, &color.x, &color.y, &color.z)) {
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*y*", (char **)keywords, &a, &b)) {
         return NULL;
     }
 
-    for (int i = 0; i < self->vertex_count; ++i) {
-        self->vertex[i].color = color;
+    const int count = broadcast_count(a, sizeof(quat_t), b, sizeof(vec_t));
+    if (count < 0) {
+        return NULL;
     }
-    Py_RETURN_NONE;
+
+    PyObject * res = PyBytes_FromStringAndSize(NULL, count * sizeof(vec_t));
+    vec_t * ptr = (vec_t *)PyBytes_AsString(res);
+    const quat_t * q = (quat_t *)a.buf;
+    const vec_t * v = (vec_t *)b.buf;
+    broadcast_map(ptr, q, a.len == sizeof(quat_t), v, b.len == sizeof(vec_t), count, [](const quat_t & x, const vec_t & y) {
+        return rotate_vector(x, y);
+    });
+
+    PyBuffer_Release(&a);
+    PyBuffer_Release(&b);
+    return res;
 }
 
-static PyObject * Scene_meth_add(Scene * self, PyObject * args, PyObject * kwargs) {
-    return Mesh_meth_add(self->base, args, kwargs);
+static inline quat_t quatslerp(const quat_t & a, const quat_t & b, float t) {
+    float d = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    const float sign = d < 0.0f ? -1.0f : 1.0f;
+    d *= sign;
+    float wa = 1.0f - t;
+    float wb = t * sign;
+    if (d < 0.9995f) {
+        const float angle = acosf(d);
+        const float inv = 1.0f / sinf(angle);
+        wa = sinf((1.0f - t) * angle) * inv;
+        wb = sinf(t * angle) * inv * sign;
+    }
+    const quat_t q = {a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb};
+    const float l = 1.0f / sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    return {q.x * l, q.y * l, q.z * l, q.w * l};
 }
 
-static PyObject * Scene_meth_bake(Scene * self, PyObject * args) {
-    Mesh * stack[1024];
-    int stack_index;
+static PyObject * meth_quat_slerp(PyObject * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"a", "b", "t", NULL};
 
-    stack_index = 0;
-    stack[0] = self->base->child;
-    int total_vertex_count = 0;
-    while (true) {
-        Mesh * mesh = stack[stack_index];
-        if (mesh) {
-            mesh->world_transform = apply_transform(mesh->parent->world_transform, mesh->local_transform);
-            total_vertex_count += mesh->vertex_count;
-            stack[stack_index] = mesh->slibling;
-            if (mesh->child) {
-                stack[++stack_index] = mesh->child;
-            }
-        } else {
-            --stack_index;
-            if (stack_index < 0) {
-                break;
-            }
-        }
-    }
+    Py_buffer a = {};
+    Py_buffer b = {};
+    float t;
 
-    PyObject * res = PyBytes_FromStringAndSize(NULL, total_vertex_count * sizeof(vert_t));
-    vert_t * ptr = (vert_t *)PyBytes_AsString(res);
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*y*f", (char **)keywords, &a, &b, &t)) {
+        return NULL;
+    }
 
-    stack_index = 0;
-    stack[0] = self->base->child;
-    while (true) {
-        Mesh * mesh = stack[stack_index];
-        if (mesh) {
-            const trans_t & t = mesh->world_transform;
-            vert_t * src = mesh->vertex;
-            int count = mesh->vertex_count;
-            while (count--) {
-                *ptr++ = apply_transform(t, *src++);
-            }
-            stack[stack_index] = mesh->slibling;
-            if (mesh->child) {
-                stack[++stack_index] = mesh->child;
-            }
-        } else {
-            --stack_index;
-            if (stack_index < 0) {
-                break;
-            }
-        }
+    const int count = broadcast_count(a, sizeof(quat_t), b, sizeof(quat_t));
+    if (count < 0) {
+        return NULL;
     }
 
+    PyObject * res = PyBytes_FromStringAndSize(NULL, count * sizeof(quat_t));
+    quat_t * ptr = (quat_t *)PyBytes_AsString(res);
+    const quat_t * qa = (quat_t *)a.buf;
+    const quat_t * qb = (quat_t *)b.buf;
+    broadcast_map(ptr, qa, a.len == sizeof(quat_t), qb, b.len == sizeof(quat_t), count, [t](const quat_t & x, const quat_t & y) {
+        return quatslerp(x, y, t);
+    });
+
+    PyBuffer_Release(&a);
+    PyBuffer_Release(&b);
     return res;
 }
 
-PyObject * Mesh_get_position(Mesh * self, void * closure) {
-    const vec_t & p = self->local_transform.position;
-    return Py_BuildValue("(fff)", p.x, p.y, p.z);
-}
+static PyObject * meth_quat_inverse(PyObject * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"rotation", NULL};
 
-int Mesh_set_position(Mesh * self, PyObject * value, void * closure) {
-    PyObject * tup = PySequence_Tuple(value);
-    self->local_transform.position = {
-        (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 0)),
-        (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 1)),
-        (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 2)),
-    };
-    Py_DECREF(tup);
-    return 0;
-}
+    Py_buffer a = {};
 
-PyObject * Mesh_get_rotation(Mesh * self, void * closure) {
-    const quat_t & q = self->local_transform.rotation;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*", (char **)keywords, &a)) {
+        return NULL;
+    }
+
+    if (a.len % sizeof(quat_t)) {
+        PyErr_Format(PyExc_ValueError, "buffer sizes do not match");
+        PyBuffer_Release(&a);
+        return NULL;
+    }
+
+    const int count = (int)(a.len / sizeof(quat_t));
+    PyObject * res = PyBytes_FromStringAndSize(NULL, count * sizeof(quat_t));
+    quat_t * ptr = (quat_t *)PyBytes_AsString(res);
+    const quat_t * q = (quat_t *)a.buf;
+    for (int i = 0; i < count; ++i) {
+        const float l = 1.0f / (q[i].x * q[i].x + q[i].y * q[i].y + q[i].z * q[i].z + q[i].w * q[i].w);
+        ptr[i] = {-q[i].x * l, -q[i].y * l, -q[i].z * l, q[i].w * l};
+    }
+
+    PyBuffer_Release(&a);
+    return res;
+}
+
+static PyObject * meth_transform_points(PyObject * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"transform", "points", NULL};
+
+    Py_buffer a = {};
+    Py_buffer b = {};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*y*", (char **)keywords, &a, &b)) {
+        return NULL;
+    }
+
+    const int count = broadcast_count(a, sizeof(trans_t), b, sizeof(vec_t));
+    if (count < 0) {
+        return NULL;
+    }
+
+    PyObject * res = PyBytes_FromStringAndSize(NULL, count * sizeof(vec_t));
+    vec_t * ptr = (vec_t *)PyBytes_AsString(res);
+    const trans_t * t = (trans_t *)a.buf;
+    const vec_t * v = (vec_t *)b.buf;
+    broadcast_map(ptr, t, a.len == sizeof(trans_t), v, b.len == sizeof(vec_t), count, [](const trans_t & x, const vec_t & y) {
+        return transform_vertex(x, y);
+    });
+
+    PyBuffer_Release(&a);
+    PyBuffer_Release(&b);
+    return res;
+}
+
+static Scene * meth_scene(PyObject * self, PyObject * args, PyObject * kwargs) {
+    Scene * res = PyObject_New(Scene, Scene_type);
+    res->base = new_mesh(0);
+    res->base->scene = res;
+    res->names = PyDict_New();
+    res->tags = PyDict_New();
+    res->node_count = 0;
+    res->node_capacity = 0;
+    res->node_parent = NULL;
+    res->node_local = NULL;
+    res->node_world = NULL;
+    res->node_mesh = NULL;
+    res->node_baked = NULL;
+    res->node_previous = NULL;
+    res->baked_object = NULL;
+    res->baked_buffer = NULL;
+    res->baked_size = 0;
+    res->previous_origin = {};
+    res->previous_valid = false;
+    res->structure = 1;
+    res->order_structure = 0;
+    res->order_count = 0;
+    res->order = NULL;
+    res->level_count = 0;
+    res->level = NULL;
+    res->transform_epoch = 0;
+    res->objects = NULL;
+    res->object_keys = NULL;
+    res->object_count = 0;
+    return res;
+}
+
+static void reserve_nodes(Scene * scene, int count) {
+    if (scene->node_capacity >= count) {
+        return;
+    }
+    int capacity = scene->node_capacity ? scene->node_capacity : 64;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    scene->node_parent = (int *)PyMem_Realloc(scene->node_parent, capacity * sizeof(int));
+    scene->node_local = (trans_t *)PyMem_Realloc(scene->node_local, capacity * sizeof(trans_t));
+    scene->node_world = (trans_t *)PyMem_Realloc(scene->node_world, capacity * sizeof(trans_t));
+    scene->node_mesh = (Mesh **)PyMem_Realloc(scene->node_mesh, capacity * sizeof(Mesh *));
+    scene->node_baked = (baked_t *)PyMem_Realloc(scene->node_baked, capacity * sizeof(baked_t));
+    scene->node_previous = (previous_t *)PyMem_Realloc(scene->node_previous, capacity * sizeof(previous_t));
+    scene->node_capacity = capacity;
+}
+
+static void add_group(PyObject * index, PyObject * key, Mesh * mesh) {
+    PyObject * group = PyDict_GetItem(index, key);
+    if (!group) {
+        group = PyDict_New();
+        PyDict_SetItem(index, key, group);
+        Py_DECREF(group);
+    }
+    PyDict_SetItem(group, (PyObject *)mesh, Py_None);
+}
+static void remove_group(PyObject * index, PyObject * key, Mesh * mesh) {
+    PyObject * group = PyDict_GetItem(index, key);
+    if (group && PyDict_GetItem(group, (PyObject *)mesh)) {
+        PyDict_DelItem(group, (PyObject *)mesh);
+        if (!PyDict_GET_SIZE(group)) {
+            PyDict_DelItem(index, key);
+        }
+    }
+}
+static void index_mesh(Scene * scene, Mesh * mesh) {
+    if (mesh->name != Py_None) {
+        add_group(scene->names, mesh->name, mesh);
+    }
+    for (int i = 0; i < PyTuple_GET_SIZE(mesh->tags); ++i) {
+        add_group(scene->tags, PyTuple_GET_ITEM(mesh->tags, i), mesh);
+    }
+}
+static void unindex_mesh(Scene * scene, Mesh * mesh) {
+    if (mesh->name != Py_None) {
+        remove_group(scene->names, mesh->name, mesh);
+    }
+    for (int i = 0; i < PyTuple_GET_SIZE(mesh->tags); ++i) {
+        remove_group(scene->tags, PyTuple_GET_ITEM(mesh->tags, i), mesh);
+    }
+}
+
+static void set_scene(Mesh * mesh, Scene * scene) {
+    Mesh * stack[1024];
+    int stack_index;
+
+    stack_index = 0;
+    stack[0] = mesh;
+    while (true) {
+        Mesh * node = stack[stack_index];
+        if (node) {
+            if (node->scene) {
+                unindex_mesh(node->scene, node);
+                node->scene->structure += 1;
+            }
+            node->scene = scene;
+            node->baked.offset = -1;
+            transform_epoch += 1;
+            node->previous.valid = false;
+            if (scene) {
+                index_mesh(scene, node);
+                scene->structure += 1;
+            }
+            stack[stack_index] = node != mesh ? node->slibling : NULL;
+            if (node->child) {
+                stack[++stack_index] = node->child;
+            }
+        } else {
+            --stack_index;
+            if (stack_index < 0) {
+                break;
+            }
+        }
+    }
+}
+
+static void detach_mesh(Mesh * mesh) {
+    Mesh ** link = &mesh->parent->child;
+    while (*link != mesh) {
+        link = &(*link)->slibling;
+    }
+    *link = mesh->slibling;
+    mesh->parent = NULL;
+    mesh->slibling = NULL;
+    set_scene(mesh, NULL);
+}
+
+static int flatten(Mesh * root, Mesh *** nodes, int ** parents) {
+    Mesh * stack[1024];
+    int parent_stack[1024];
+    int stack_index;
+
+    int count = 0;
+    int capacity = 64;
+    Mesh ** res = (Mesh **)PyMem_Malloc(capacity * sizeof(Mesh *));
+    int * parent = parents ? (int *)PyMem_Malloc(capacity * sizeof(int)) : NULL;
+
+    stack_index = 0;
+    stack[0] = root->child;
+    parent_stack[0] = -1;
+    while (true) {
+        Mesh * mesh = stack[stack_index];
+        if (mesh) {
+            if (count == capacity) {
+                capacity *= 2;
+                res = (Mesh **)PyMem_Realloc(res, capacity * sizeof(Mesh *));
+                if (parent) {
+                    parent = (int *)PyMem_Realloc(parent, capacity * sizeof(int));
+                }
+            }
+            res[count] = mesh;
+            if (parent) {
+                parent[count] = parent_stack[stack_index];
+            }
+            stack[stack_index] = mesh->slibling;
+            if (mesh->child) {
+                stack[++stack_index] = mesh->child;
+                parent_stack[stack_index] = count;
+            }
+            ++count;
+        } else {
+            --stack_index;
+            if (stack_index < 0) {
+                break;
+            }
+        }
+    }
+
+    *nodes = res;
+    if (parents) {
+        *parents = parent;
+    }
+    return count;
+}
+
+static PyObject * node_list(Mesh * root) {
+    Mesh ** nodes;
+    int count = flatten(root, &nodes, NULL);
+    PyObject * res = PyList_New(count);
+    for (int i = 0; i < count; ++i) {
+        Py_INCREF(nodes[i]);
+        PyList_SET_ITEM(res, i, (PyObject *)nodes[i]);
+    }
+    PyMem_Free(nodes);
+    return res;
+}
+
+static PyObject * Mesh_meth_add(Mesh * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"mesh", NULL};
+
+    Mesh * mesh;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!", (char **)keywords, Mesh_type, &mesh)) {
+        return NULL;
+    }
+
+    for (Mesh * ptr = self; ptr; ptr = ptr->parent) {
+        if (ptr == mesh) {
+            PyErr_Format(PyExc_ValueError, "cannot add a mesh to itself or its descendants");
+            return NULL;
+        }
+    }
+
+    if (!uniform_scale(self->local_transform.scale)) {
+        PyErr_Format(PyExc_ValueError, "cannot add children to a mesh with non-uniform scale");
+        return NULL;
+    }
+
+    Py_INCREF(mesh);
+    if (mesh->parent) {
+        detach_mesh(mesh);
+        Py_DECREF(mesh);
+    }
+    mesh->parent = self;
+    mesh->slibling = self->child;
+    self->child = mesh;
+    set_scene(mesh, self->scene);
+    Py_RETURN_NONE;
+}
+
+static PyObject * Mesh_meth_remove(Mesh * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"mesh", NULL};
+
+    Mesh * mesh;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!", (char **)keywords, Mesh_type, &mesh)) {
+        return NULL;
+    }
+
+    if (mesh->parent != self) {
+        PyErr_Format(PyExc_ValueError, "mesh is not a child");
+        return NULL;
+    }
+
+    detach_mesh(mesh);
+    Py_DECREF(mesh);
+    Py_RETURN_NONE;
+}
+
+static Mesh * copy_mesh(Mesh * mesh) {
+    Mesh * res = new_mesh(0);
+    Py_INCREF(mesh->name);
+    Py_SETREF(res->name, mesh->name);
+    Py_INCREF(mesh->tags);
+    Py_SETREF(res->tags, mesh->tags);
+    res->visible = mesh->visible;
+    res->layers = mesh->layers;
+    res->dynamic = mesh->dynamic;
+    res->linear_velocity = mesh->linear_velocity;
+    res->angular_velocity = mesh->angular_velocity;
+    res->local_transform = mesh->local_transform;
+    res->world_transform = mesh->world_transform;
+    res->position = mesh->position;
+    res->world_position = mesh->world_position;
+    share_vertex(mesh, res);
+    if (mesh->emitter) {
+        res->emitter = new_emitter(mesh->emitter->capacity);
+        const emitter_t * src = mesh->emitter;
+        emitter_t * dst = res->emitter;
+        dst->rate = src->rate;
+        dst->lifetime = src->lifetime;
+        dst->velocity = src->velocity;
+        dst->spread = src->spread;
+        dst->size[0] = src->size[0];
+        dst->size[1] = src->size[1];
+        dst->color[0] = src->color[0];
+        dst->color[1] = src->color[1];
+    }
+    return res;
+}
+
+static void copy_children(Mesh * src, Mesh * dst) {
+    Mesh ** nodes;
+    int * parents;
+    int count = flatten(src, &nodes, &parents);
+
+    Mesh ** copies = (Mesh **)PyMem_Malloc(count * sizeof(Mesh *));
+    for (int i = 0; i < count; ++i) {
+        copies[i] = copy_mesh(nodes[i]);
+    }
+
+    for (int i = count - 1; i >= 0; --i) {
+        Mesh * parent = parents[i] < 0 ? dst : copies[parents[i]];
+        copies[i]->parent = parent;
+        copies[i]->slibling = parent->child;
+        parent->child = copies[i];
+    }
+
+    PyMem_Free(copies);
+    PyMem_Free(nodes);
+    PyMem_Free(parents);
+}
+
+static PyObject * Mesh_meth_clone(Mesh * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"deep", NULL};
+
+    int deep = true;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|p", (char **)keywords, &deep)) {
+        return NULL;
+    }
+
+    Mesh * res = copy_mesh(self);
+    if (deep) {
+        copy_children(self, res);
+    }
+    return (PyObject *)res;
+}
+
+static PyObject * Mesh_meth_descendants(Mesh * self, PyObject * args) {
+    return node_list(self);
+}
+
+static PyObject * Mesh_meth_touch(Mesh * self, PyObject * args) {
+    write_vertex(self);
+    Py_RETURN_NONE;
+}
+
+static int paint_targets(Mesh * self, bool recursive, Mesh *** targets) {
+    if (!recursive) {
+        *targets = (Mesh **)PyMem_Malloc(sizeof(Mesh *));
+        (*targets)[0] = self;
+        return 1;
+    }
+    Mesh ** nodes;
+    const int count = flatten(self, &nodes, NULL);
+    *targets = (Mesh **)PyMem_Malloc((count + 1) * sizeof(Mesh *));
+    (*targets)[0] = self;
+    memcpy(*targets + 1, nodes, count * sizeof(Mesh *));
+    PyMem_Free(nodes);
+    return count + 1;
+}
+
+static PyObject * Mesh_meth_paint(Mesh * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"color", "recursive", NULL};
+
+    vec_t color;
+    int recursive = false;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "(fff)|p", (char **)keywords, &color.x, &color.y, &color.z, &recursive)) {
+        return NULL;
+    }
+
+    Mesh ** targets;
+    const int target_count = paint_targets(self, recursive, &targets);
+    for (int k = 0; k < target_count; ++k) {
+        Mesh * mesh = targets[k];
+        write_vertex(mesh);
+        for (int i = 0; i < mesh->vertex_count; ++i) {
+            mesh->vertex[i].color = color;
+        }
+    }
+    PyMem_Free(targets);
+    Py_RETURN_NONE;
+}
+
+static inline unsigned hash_bytes(const void * data, int size) {
+    const unsigned char * ptr = (const unsigned char *)data;
+    unsigned res = 2166136261u;
+    while (size--) {
+        res = (res ^ *ptr++) * 16777619u;
+    }
+    return res;
+}
+
+static int weld_vertices(const vert_t * vertex, int count, int * remap, bool position_only) {
+    const int size = position_only ? sizeof(vec_t) : sizeof(vert_t);
+    int capacity = 64;
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+    int * table = (int *)PyMem_Malloc(capacity * sizeof(int));
+    int * first = (int *)PyMem_Malloc(count * sizeof(int));
+    memset(table, -1, capacity * sizeof(int));
+
+    int unique = 0;
+    for (int i = 0; i < count; ++i) {
+        unsigned slot = hash_bytes(vertex + i, size) & (capacity - 1);
+        while (table[slot] >= 0 && memcmp(vertex + first[table[slot]], vertex + i, size)) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (table[slot] < 0) {
+            table[slot] = unique;
+            first[unique++] = i;
+        }
+        remap[i] = table[slot];
+    }
+
+    PyMem_Free(table);
+    PyMem_Free(first);
+    return unique;
+}
+
+static void vertex_triangles(const int * indices, int triangle_count, int vertex_count, int ** offsets, int ** triangles) {
+    int * offset = (int *)PyMem_Malloc((vertex_count + 1) * sizeof(int));
+    int * triangle = (int *)PyMem_Malloc(triangle_count * 3 * sizeof(int));
+    memset(offset, 0, (vertex_count + 1) * sizeof(int));
+    for (int i = 0; i < triangle_count * 3; ++i) {
+        offset[indices[i] + 1] += 1;
+    }
+    for (int i = 0; i < vertex_count; ++i) {
+        offset[i + 1] += offset[i];
+    }
+    int * cursor = (int *)PyMem_Malloc(vertex_count * sizeof(int));
+    memcpy(cursor, offset, vertex_count * sizeof(int));
+    for (int i = 0; i < triangle_count * 3; ++i) {
+        triangle[cursor[indices[i]]++] = i / 3;
+    }
+    PyMem_Free(cursor);
+    *offsets = offset;
+    *triangles = triangle;
+}
+
+static void tipsify(const int * indices, int triangle_count, int vertex_count, int cache_size, int * order, char * cluster_start) {
+    int * offset;
+    int * adjacency;
+    vertex_triangles(indices, triangle_count, vertex_count, &offset, &adjacency);
+
+    int * live = (int *)PyMem_Malloc(vertex_count * sizeof(int));
+    int * cache_time = (int *)PyMem_Malloc(vertex_count * sizeof(int));
+    int * dead_end = (int *)PyMem_Malloc(triangle_count * 3 * sizeof(int));
+    int * candidates = (int *)PyMem_Malloc(triangle_count * 3 * sizeof(int));
+    char * emitted = (char *)PyMem_Malloc(triangle_count);
+    for (int i = 0; i < vertex_count; ++i) {
+        live[i] = offset[i + 1] - offset[i];
+        cache_time[i] = 0;
+    }
+    memset(emitted, 0, triangle_count);
+    memset(cluster_start, 0, triangle_count);
+
+    int dead_end_count = 0;
+    int time = cache_size + 1;
+    int cursor = 0;
+    int output = 0;
+    int fanning = vertex_count ? 0 : -1;
+    bool jump = true;
+
+    while (fanning >= 0) {
+        int candidate_count = 0;
+        for (int j = offset[fanning]; j < offset[fanning + 1]; ++j) {
+            const int t = adjacency[j];
+            if (emitted[t]) {
+                continue;
+            }
+            if (jump) {
+                cluster_start[output] = 1;
+                jump = false;
+            }
+            for (int k = 0; k < 3; ++k) {
+                const int v = indices[t * 3 + k];
+                dead_end[dead_end_count++] = v;
+                candidates[candidate_count++] = v;
+                live[v] -= 1;
+                if (time - cache_time[v] > cache_size) {
+                    cache_time[v] = time++;
+                }
+            }
+            emitted[t] = 1;
+            order[output++] = t;
+        }
+
+        int best = -1;
+        int best_priority = -1;
+        for (int j = 0; j < candidate_count; ++j) {
+            const int v = candidates[j];
+            if (live[v] > 0) {
+                int priority = 0;
+                if (time - cache_time[v] + 2 * live[v] <= cache_size) {
+                    priority = time - cache_time[v];
+                }
+                if (priority > best_priority) {
+                    best_priority = priority;
+                    best = v;
+                }
+            }
+        }
+
+        if (best < 0) {
+            while (dead_end_count && best < 0) {
+                const int v = dead_end[--dead_end_count];
+                if (live[v] > 0) {
+                    best = v;
+                }
+            }
+        }
+
+        if (best < 0) {
+            while (cursor < vertex_count && !live[cursor]) {
+                ++cursor;
+            }
+            best = cursor < vertex_count ? cursor : -1;
+            jump = true;
+        }
+
+        fanning = best;
+    }
+
+    PyMem_Free(offset);
+    PyMem_Free(adjacency);
+    PyMem_Free(live);
+    PyMem_Free(cache_time);
+    PyMem_Free(dead_end);
+    PyMem_Free(candidates);
+    PyMem_Free(emitted);
+}
+
+struct cluster_sort_t {
+    float key;
+    int first;
+    int count;
+};
+
+static int compare_clusters(const void * a, const void * b) {
+    const float x = ((const cluster_sort_t *)a)->key;
+    const float y = ((const cluster_sort_t *)b)->key;
+    return x > y ? -1 : x < y ? 1 : 0;
+}
+
+static void sort_overdraw(const vert_t * vertex, int * order, const char * cluster_start, int triangle_count) {
+    vec_t center = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < triangle_count * 3; ++i) {
+        center = {center.x + vertex[i].vertex.x, center.y + vertex[i].vertex.y, center.z + vertex[i].vertex.z};
+    }
+    const float inv = triangle_count ? 1.0f / (triangle_count * 3) : 0.0f;
+    center = {center.x * inv, center.y * inv, center.z * inv};
+
+    cluster_sort_t * clusters = (cluster_sort_t *)PyMem_Malloc(triangle_count * sizeof(cluster_sort_t));
+    int cluster_count = 0;
+    for (int i = 0; i < triangle_count; ++i) {
+        if (cluster_start[i] || !cluster_count) {
+            clusters[cluster_count++] = {0.0f, i, 0};
+        }
+        clusters[cluster_count - 1].count += 1;
+    }
+
+    for (int c = 0; c < cluster_count; ++c) {
+        vec_t p = {0.0f, 0.0f, 0.0f};
+        vec_t n = {0.0f, 0.0f, 0.0f};
+        float total = 0.0f;
+        for (int i = clusters[c].first; i < clusters[c].first + clusters[c].count; ++i) {
+            const vec_t & a = vertex[order[i] * 3 + 0].vertex;
+            const vec_t & b = vertex[order[i] * 3 + 1].vertex;
+            const vec_t & d = vertex[order[i] * 3 + 2].vertex;
+            const vec_t u = {b.x - a.x, b.y - a.y, b.z - a.z};
+            const vec_t v = {d.x - a.x, d.y - a.y, d.z - a.z};
+            const vec_t w = {u.y * v.z - u.z * v.y, u.z * v.x - u.x * v.z, u.x * v.y - u.y * v.x};
+            const float area = sqrtf(w.x * w.x + w.y * w.y + w.z * w.z);
+            p = {p.x + (a.x + b.x + d.x) * area, p.y + (a.y + b.y + d.y) * area, p.z + (a.z + b.z + d.z) * area};
+            n = {n.x + w.x, n.y + w.y, n.z + w.z};
+            total += area;
+        }
+        const float scale = total > 0.0f ? 1.0f / (total * 3.0f) : 0.0f;
+        const vec_t m = total > 0.0f ? vec_t{p.x * scale, p.y * scale, p.z * scale} : center;
+        clusters[c].key = (m.x - center.x) * n.x + (m.y - center.y) * n.y + (m.z - center.z) * n.z;
+    }
+
+    qsort(clusters, cluster_count, sizeof(cluster_sort_t), compare_clusters);
+
+    int * sorted = (int *)PyMem_Malloc(triangle_count * sizeof(int));
+    int output = 0;
+    for (int c = 0; c < cluster_count; ++c) {
+        memcpy(sorted + output, order + clusters[c].first, clusters[c].count * sizeof(int));
+        output += clusters[c].count;
+    }
+    memcpy(order, sorted, triangle_count * sizeof(int));
+
+    PyMem_Free(sorted);
+    PyMem_Free(clusters);
+}
+
+static PyObject * Mesh_meth_optimize(Mesh * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"vertex_cache", "overdraw", "fetch", "cache_size", NULL};
+
+    int vertex_cache = true;
+    int overdraw = true;
+    int fetch = true;
+    int cache_size = 16;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|pppi", (char **)keywords, &vertex_cache, &overdraw, &fetch, &cache_size)) {
+        return NULL;
+    }
+
+    if (cache_size <= 0) {
+        PyErr_Format(PyExc_ValueError, "cache_size must be positive");
+        return NULL;
+    }
+
+    write_vertex(self);
+
+    const int triangle_count = self->vertex_count / 3;
+    const int index_count = triangle_count * 3;
+    int * indices = (int *)PyMem_Malloc(index_count * sizeof(int));
+    const int unique = weld_vertices(self->vertex, index_count, indices, false);
+
+    int * order = (int *)PyMem_Malloc(triangle_count * sizeof(int));
+    char * cluster_start = (char *)PyMem_Malloc(triangle_count);
+    if (vertex_cache) {
+        tipsify(indices, triangle_count, unique, cache_size, order, cluster_start);
+    } else {
+        for (int i = 0; i < triangle_count; ++i) {
+            order[i] = i;
+            cluster_start[i] = !(i % 64);
+        }
+    }
+
+    if (overdraw) {
+        sort_overdraw(self->vertex, order, cluster_start, triangle_count);
+    }
+
+    vert_t * soup = (vert_t *)PyMem_Malloc(index_count * sizeof(vert_t));
+    int * sorted = (int *)PyMem_Malloc(index_count * sizeof(int));
+    for (int i = 0; i < triangle_count; ++i) {
+        memcpy(soup + i * 3, self->vertex + order[i] * 3, 3 * sizeof(vert_t));
+        memcpy(sorted + i * 3, indices + order[i] * 3, 3 * sizeof(int));
+    }
+    memcpy(self->vertex, soup, index_count * sizeof(vert_t));
+    self->vertex_count = index_count;
+
+    int * fetch_remap = (int *)PyMem_Malloc(unique * sizeof(int));
+    memset(fetch_remap, -1, unique * sizeof(int));
+    int next = 0;
+    if (fetch) {
+        for (int i = 0; i < index_count; ++i) {
+            if (fetch_remap[sorted[i]] < 0) {
+                fetch_remap[sorted[i]] = next++;
+            }
+        }
+    } else {
+        for (int i = 0; i < unique; ++i) {
+            fetch_remap[i] = i;
+        }
+    }
+
+    PyObject * vertex_bytes = PyBytes_FromStringAndSize(NULL, unique * sizeof(vert_t));
+    PyObject * index_bytes = PyBytes_FromStringAndSize(NULL, index_count * sizeof(int));
+    vert_t * vertex = (vert_t *)PyBytes_AsString(vertex_bytes);
+    int * index = (int *)PyBytes_AsString(index_bytes);
+    for (int i = 0; i < index_count; ++i) {
+        index[i] = fetch_remap[sorted[i]];
+        vertex[index[i]] = soup[i];
+    }
+
+    PyMem_Free(indices);
+    PyMem_Free(order);
+    PyMem_Free(cluster_start);
+    PyMem_Free(soup);
+    PyMem_Free(sorted);
+    PyMem_Free(fetch_remap);
+    return Py_BuildValue("(NN)", vertex_bytes, index_bytes);
+}
+
+static void meshlet_bounds(const vert_t * vertex, meshlet_t & meshlet) {
+    const vert_t * first = vertex + meshlet.first_triangle * 3;
+    const int count = meshlet.triangle_count * 3;
+
+    vec_t lo = first[0].vertex;
+    vec_t hi = first[0].vertex;
+    for (int i = 1; i < count; ++i) {
+        const vec_t & v = first[i].vertex;
+        lo = {fminf(lo.x, v.x), fminf(lo.y, v.y), fminf(lo.z, v.z)};
+        hi = {fmaxf(hi.x, v.x), fmaxf(hi.y, v.y), fmaxf(hi.z, v.z)};
+    }
+    const vec_t center = {(lo.x + hi.x) * 0.5f, (lo.y + hi.y) * 0.5f, (lo.z + hi.z) * 0.5f};
+    float radius = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        const vec_t & v = first[i].vertex;
+        const vec_t d = {v.x - center.x, v.y - center.y, v.z - center.z};
+        radius = fmaxf(radius, d.x * d.x + d.y * d.y + d.z * d.z);
+    }
+    meshlet.center = center;
+    meshlet.radius = sqrtf(radius);
+
+    vec_t axis = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < count; i += 3) {
+        if (degenerate(first[i].vertex, first[i + 1].vertex, first[i + 2].vertex)) {
+            continue;
+        }
+        const vec_t & n = triangle_normal(first[i].vertex, first[i + 1].vertex, first[i + 2].vertex);
+        axis = {axis.x + n.x, axis.y + n.y, axis.z + n.z};
+    }
+
+    meshlet.cone_axis = {0.0f, 0.0f, 0.0f};
+    meshlet.cone_cutoff = 1.0f;
+    if (axis.x * axis.x + axis.y * axis.y + axis.z * axis.z < 1e-12f) {
+        return;
+    }
+    axis = normalize(axis);
+    float min_dot = 1.0f;
+    for (int i = 0; i < count; i += 3) {
+        if (degenerate(first[i].vertex, first[i + 1].vertex, first[i + 2].vertex)) {
+            continue;
+        }
+        const vec_t & n = triangle_normal(first[i].vertex, first[i + 1].vertex, first[i + 2].vertex);
+        min_dot = fminf(min_dot, n.x * axis.x + n.y * axis.y + n.z * axis.z);
+    }
+    if (min_dot > 0.0f) {
+        meshlet.cone_axis = axis;
+        meshlet.cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+    }
+}
+
+static int build_meshlets(const vert_t * vertex, int triangle_count, int max_vertices, int max_triangles, int * order, meshlet_t ** meshlets) {
+    int * indices = (int *)PyMem_Malloc(triangle_count * 3 * sizeof(int));
+    const int unique = weld_vertices(vertex, triangle_count * 3, indices, false);
+
+    int * offset;
+    int * adjacency;
+    vertex_triangles(indices, triangle_count, unique, &offset, &adjacency);
+
+    int * marker = (int *)PyMem_Malloc(unique * sizeof(int));
+    int * used = (int *)PyMem_Malloc(max_vertices * sizeof(int));
+    char * emitted = (char *)PyMem_Malloc(triangle_count);
+    meshlet_t * res = (meshlet_t *)PyMem_Malloc(triangle_count * sizeof(meshlet_t));
+    memset(marker, -1, unique * sizeof(int));
+    memset(emitted, 0, triangle_count);
+
+    int meshlet_count = 0;
+    int output = 0;
+    int cursor = 0;
+
+    while (output < triangle_count) {
+        const int id = meshlet_count;
+        int used_count = 0;
+        int count = 0;
+
+        while (count < max_triangles) {
+            int best = -1;
+            int best_cost = 4;
+            for (int i = 0; i < used_count && best_cost; ++i) {
+                for (int j = offset[used[i]]; j < offset[used[i] + 1]; ++j) {
+                    const int t = adjacency[j];
+                    if (emitted[t]) {
+                        continue;
+                    }
+                    int cost = 0;
+                    for (int k = 0; k < 3; ++k) {
+                        cost += marker[indices[t * 3 + k]] != id;
+                    }
+                    if (cost < best_cost && used_count + cost <= max_vertices) {
+                        best = t;
+                        best_cost = cost;
+                    }
+                }
+            }
+
+            if (best < 0) {
+                while (emitted[cursor]) {
+                    ++cursor;
+                }
+                if (used_count + 3 > max_vertices) {
+                    break;
+                }
+                best = cursor;
+            }
+
+            for (int k = 0; k < 3; ++k) {
+                const int v = indices[best * 3 + k];
+                if (marker[v] != id) {
+                    marker[v] = id;
+                    used[used_count++] = v;
+                }
+            }
+            emitted[best] = 1;
+            order[output++] = best;
+            count += 1;
+
+            if (output == triangle_count) {
+                break;
+            }
+        }
+
+        res[meshlet_count++] = {{}, 0.0f, {}, 1.0f, output - count, count};
+    }
+
+    PyMem_Free(indices);
+    PyMem_Free(offset);
+    PyMem_Free(adjacency);
+    PyMem_Free(marker);
+    PyMem_Free(used);
+    PyMem_Free(emitted);
+    *meshlets = (meshlet_t *)PyMem_Realloc(res, meshlet_count * sizeof(meshlet_t));
+    return meshlet_count;
+}
+
+struct edge_t {
+    int a;
+    int b;
+    int triangle;
+};
+
+static int find_edge(const edge_t * edges, int capacity, const char * visited, int a, int b) {
+    unsigned slot = (a * 73856093u ^ b * 19349663u) & (capacity - 1);
+    while (edges[slot].triangle >= 0) {
+        const edge_t & e = edges[slot];
+        if (e.a == a && e.b == b && !visited[e.triangle]) {
+            return e.triangle;
+        }
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return -1;
+}
+
+static void append_join(int ** strip, int * count, int first) {
+    if (*count) {
+        const int last = (*strip)[*count - 1];
+        const bool odd = *count & 1;
+        (*strip)[(*count)++] = last;
+        (*strip)[(*count)++] = first;
+        if (odd) {
+            (*strip)[(*count)++] = first;
+        }
+    }
+}
+
+static int stripify(const vert_t * vertex, int triangle_count, int ** strip) {
+    int * indices = (int *)PyMem_Malloc(triangle_count * 3 * sizeof(int));
+    const int unique = weld_vertices(vertex, triangle_count * 3, indices, false);
+
+    int * source = (int *)PyMem_Malloc(unique * sizeof(int));
+    for (int i = triangle_count * 3 - 1; i >= 0; --i) {
+        source[indices[i]] = i;
+    }
+
+    int capacity = 64;
+    while (capacity < triangle_count * 6) {
+        capacity *= 2;
+    }
+    edge_t * edges = (edge_t *)PyMem_Malloc(capacity * sizeof(edge_t));
+    memset(edges, -1, capacity * sizeof(edge_t));
+    char * visited = (char *)PyMem_Malloc(triangle_count);
+    for (int i = 0; i < triangle_count; ++i) {
+        const int * t = indices + i * 3;
+        visited[i] = t[0] == t[1] || t[1] == t[2] || t[2] == t[0];
+        if (visited[i]) {
+            continue;
+        }
+        for (int k = 0; k < 3; ++k) {
+            const int a = t[k];
+            const int b = t[(k + 1) % 3];
+            unsigned slot = (a * 73856093u ^ b * 19349663u) & (capacity - 1);
+            while (edges[slot].triangle >= 0) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            edges[slot] = {a, b, i};
+        }
+    }
+
+    int * res = (int *)PyMem_Malloc(triangle_count * 6 * sizeof(int) + sizeof(int));
+    int * current = (int *)PyMem_Malloc((triangle_count + 2) * sizeof(int));
+    int count = 0;
+
+    for (int i = 0; i < triangle_count; ++i) {
+        if (visited[i]) {
+            continue;
+        }
+        const int * t = indices + i * 3;
+        int rotation = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (find_edge(edges, capacity, visited, t[(k + 2) % 3], t[(k + 1) % 3]) >= 0) {
+                rotation = k;
+                break;
+            }
+        }
+        visited[i] = 1;
+        current[0] = t[rotation];
+        current[1] = t[(rotation + 1) % 3];
+        current[2] = t[(rotation + 2) % 3];
+        int length = 3;
+
+        while (true) {
+            const int j = length - 2;
+            const int a = current[j];
+            const int b = current[j + 1];
+            const int next = j & 1 ? find_edge(edges, capacity, visited, b, a) : find_edge(edges, capacity, visited, a, b);
+            if (next < 0) {
+                break;
+            }
+            const int * n = indices + next * 3;
+            visited[next] = 1;
+            current[length++] = n[0] != a && n[0] != b ? n[0] : n[1] != a && n[1] != b ? n[1] : n[2];
+        }
+
+        append_join(&res, &count, source[current[0]]);
+        for (int k = 0; k < length; ++k) {
+            res[count++] = source[current[k]];
+        }
+    }
+
+    PyMem_Free(indices);
+    PyMem_Free(source);
+    PyMem_Free(edges);
+    PyMem_Free(visited);
+    PyMem_Free(current);
+    *strip = (int *)PyMem_Realloc(res, count * sizeof(int) + sizeof(int));
+    return count;
+}
+
+static PyObject * Mesh_meth_build_meshlets(Mesh * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"max_vertices", "max_triangles", NULL};
+
+    int max_vertices = 64;
+    int max_triangles = 124;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|ii", (char **)keywords, &max_vertices, &max_triangles)) {
+        return NULL;
+    }
+
+    if (max_vertices < 3 || max_triangles < 1) {
+        PyErr_Format(PyExc_ValueError, "max_vertices must be at least 3 and max_triangles at least 1");
+        return NULL;
+    }
+
+    if (self->emitter) {
+        PyErr_Format(PyExc_ValueError, "cannot build meshlets for an emitter");
+        return NULL;
+    }
+
+    write_vertex(self);
+
+    const int triangle_count = self->vertex_count / 3;
+    int * order = (int *)PyMem_Malloc(triangle_count * sizeof(int));
+    meshlet_t * meshlet;
+    const int meshlet_count = build_meshlets(self->vertex, triangle_count, max_vertices, max_triangles, order, &meshlet);
+
+    vert_t * vertex = (vert_t *)PyMem_Malloc(triangle_count * 3 * sizeof(vert_t));
+    for (int i = 0; i < triangle_count; ++i) {
+        memcpy(vertex + i * 3, self->vertex + order[i] * 3, 3 * sizeof(vert_t));
+    }
+    memcpy(self->vertex, vertex, triangle_count * 3 * sizeof(vert_t));
+    PyMem_Free(vertex);
+    PyMem_Free(order);
+    self->vertex_count = triangle_count * 3;
+
+    for (int i = 0; i < meshlet_count; ++i) {
+        meshlet_bounds(self->vertex, meshlet[i]);
+    }
+
+    if (!self->geometry) {
+        self->geometry = new_geometry();
+    }
+    self->geometry->meshlet = meshlet;
+    self->geometry->meshlet_count = meshlet_count;
+    self->geometry->cluster = NULL;
+    self->geometry->cluster_count = 0;
+    return PyBytes_FromStringAndSize((char *)meshlet, meshlet_count * sizeof(meshlet_t));
+}
+
+static int compare_ints(const void * a, const void * b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+static void vertex_neighbors(const int * indices, int triangle_count, int vertex_count, int ** offsets, int ** neighbors) {
+    int * offset = (int *)PyMem_Malloc((vertex_count + 1) * sizeof(int));
+    int * neighbor = (int *)PyMem_Malloc(triangle_count * 6 * sizeof(int) + sizeof(int));
+    memset(offset, 0, (vertex_count + 1) * sizeof(int));
+    for (int i = 0; i < triangle_count * 3; ++i) {
+        offset[indices[i] + 1] += 2;
+    }
+    for (int i = 0; i < vertex_count; ++i) {
+        offset[i + 1] += offset[i];
+    }
+    int * cursor = (int *)PyMem_Malloc(vertex_count * sizeof(int) + sizeof(int));
+    memcpy(cursor, offset, vertex_count * sizeof(int));
+    for (int i = 0; i < triangle_count * 3; ++i) {
+        const int base = i - i % 3;
+        neighbor[cursor[indices[i]]++] = indices[base + (i + 1) % 3];
+        neighbor[cursor[indices[i]]++] = indices[base + (i + 2) % 3];
+    }
+    int count = 0;
+    for (int i = 0; i < vertex_count; ++i) {
+        int * row = neighbor + offset[i];
+        const int size = offset[i + 1] - offset[i];
+        qsort(row, size, sizeof(int), compare_ints);
+        offset[i] = count;
+        for (int j = 0; j < size; ++j) {
+            if (row[j] != i && (!j || row[j] != row[j - 1])) {
+                neighbor[count++] = row[j];
+            }
+        }
+    }
+    offset[vertex_count] = count;
+    PyMem_Free(cursor);
+    *offsets = offset;
+    *neighbors = neighbor;
+}
+
+static void smooth_step(const vec_t * src, vec_t * dst, const int * offset, const int * neighbor, int vertex_count, float factor) {
+    parallel_for(vertex_count, 8192, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const int size = offset[i + 1] - offset[i];
+            if (!size) {
+                dst[i] = src[i];
+                continue;
+            }
+            vec_t sum = {0.0f, 0.0f, 0.0f};
+            for (int j = offset[i]; j < offset[i + 1]; ++j) {
+                const vec_t & v = src[neighbor[j]];
+                sum = {sum.x + v.x, sum.y + v.y, sum.z + v.z};
+            }
+            const float inv = 1.0f / size;
+            dst[i] = {
+                src[i].x + (sum.x * inv - src[i].x) * factor,
+                src[i].y + (sum.y * inv - src[i].y) * factor,
+                src[i].z + (sum.z * inv - src[i].z) * factor,
+            };
+        }
+    });
+}
+static PyObject * Mesh_meth_smooth(Mesh * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"iterations", "lamb", "mu", NULL};
+
+    int iterations = 10;
+    float lamb = 0.5f;
+    float mu = 0.0f;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|iff", (char **)keywords, &iterations, &lamb, &mu)) {
+        return NULL;
+    }
+
+    if (self->emitter) {
+        PyErr_Format(PyExc_ValueError, "cannot smooth an emitter");
+        return NULL;
+    }
+
+    write_vertex(self);
+
+    const int triangle_count = self->vertex_count / 3;
+    const int index_count = triangle_count * 3;
+    int * indices = (int *)PyMem_Malloc(index_count * sizeof(int) + sizeof(int));
+    const int unique = weld_vertices(self->vertex, index_count, indices, true);
+
+    int * offset;
+    int * neighbor;
+    vertex_neighbors(indices, triangle_count, unique, &offset, &neighbor);
+
+    vec_t * position = (vec_t *)PyMem_Malloc(unique * sizeof(vec_t) + sizeof(vec_t));
+    vec_t * temp = (vec_t *)PyMem_Malloc(unique * sizeof(vec_t) + sizeof(vec_t));
+    for (int i = 0; i < index_count; ++i) {
+        position[indices[i]] = self->vertex[i].vertex;
+    }
+
+    for (int i = 0; i < iterations; ++i) {
+        smooth_step(position, temp, offset, neighbor, unique, lamb);
+        if (mu) {
+            smooth_step(temp, position, offset, neighbor, unique, mu);
+        } else {
+            vec_t * swap = position;
+            position = temp;
+            temp = swap;
+        }
+    }
+
+    vec_t * normal = temp;
+    memset(normal, 0, unique * sizeof(vec_t));
+    for (int i = 0; i < index_count; i += 3) {
+        const vec_t & a = position[indices[i + 0]];
+        const vec_t & b = position[indices[i + 1]];
+        const vec_t & c = position[indices[i + 2]];
+        const vec_t u = {b.x - a.x, b.y - a.y, b.z - a.z};
+        const vec_t v = {c.x - a.x, c.y - a.y, c.z - a.z};
+        const vec_t n = {u.y * v.z - u.z * v.y, u.z * v.x - u.x * v.z, u.x * v.y - u.y * v.x};
+        for (int k = 0; k < 3; ++k) {
+            vec_t & m = normal[indices[i + k]];
+            m = {m.x + n.x, m.y + n.y, m.z + n.z};
+        }
+    }
+
+    vert_t * vertex = self->vertex;
+    parallel_for(index_count, 16384, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const vec_t & n = normal[indices[i]];
+            vertex[i].vertex = position[indices[i]];
+            if (n.x * n.x + n.y * n.y + n.z * n.z > 0.0f) {
+                vertex[i].normal = normalize(n);
+            }
+        }
+    });
+
+    PyMem_Free(indices);
+    PyMem_Free(offset);
+    PyMem_Free(neighbor);
+    PyMem_Free(position);
+    PyMem_Free(temp);
+    Py_RETURN_NONE;
+}
+
+static int find_root(int * parent, int x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+static PyObject * Mesh_meth_split_components(Mesh * self, PyObject * args) {
+    if (self->emitter) {
+        PyErr_Format(PyExc_ValueError, "cannot split an emitter");
+        return NULL;
+    }
+
+    if (self->exports) {
+        PyErr_Format(PyExc_BufferError, "cannot split a mesh while its memory is exported");
+        return NULL;
+    }
+
+    if (!uniform_scale(self->local_transform.scale)) {
+        PyErr_Format(PyExc_ValueError, "cannot add children to a mesh with non-uniform scale");
+        return NULL;
+    }
+
+    const int triangle_count = self->vertex_count / 3;
+    const int index_count = triangle_count * 3;
+    int * indices = (int *)PyMem_Malloc(index_count * sizeof(int) + sizeof(int));
+    const int unique = weld_vertices(self->vertex, index_count, indices, true);
+
+    int * parent = (int *)PyMem_Malloc(unique * sizeof(int) + sizeof(int));
+    for (int i = 0; i < unique; ++i) {
+        parent[i] = i;
+    }
+    for (int i = 0; i < index_count; i += 3) {
+        const int a = find_root(parent, indices[i]);
+        const int b = find_root(parent, indices[i + 1]);
+        const int c = find_root(parent, indices[i + 2]);
+        parent[b] = a;
+        parent[c] = a;
+    }
+
+    int * label = (int *)PyMem_Malloc(unique * sizeof(int) + sizeof(int));
+    int * component = (int *)PyMem_Malloc(triangle_count * sizeof(int) + sizeof(int));
+    int * size = (int *)PyMem_Malloc(triangle_count * sizeof(int) + sizeof(int));
+    memset(label, -1, unique * sizeof(int));
+    int component_count = 0;
+    for (int i = 0; i < triangle_count; ++i) {
+        const int root = find_root(parent, indices[i * 3]);
+        if (label[root] < 0) {
+            size[component_count] = 0;
+            label[root] = component_count++;
+        }
+        component[i] = label[root];
+        size[component[i]] += 3;
+    }
+
+    Mesh ** meshes = (Mesh **)PyMem_Malloc(component_count * sizeof(Mesh *) + sizeof(Mesh *));
+    vert_t ** ptr = (vert_t **)PyMem_Malloc(component_count * sizeof(vert_t *) + sizeof(vert_t *));
+    for (int i = 0; i < component_count; ++i) {
+        meshes[i] = new_mesh(size[i]);
+        meshes[i]->visible = self->visible;
+        meshes[i]->layers = self->layers;
+        ptr[i] = meshes[i]->vertex;
+    }
+    for (int i = 0; i < triangle_count; ++i) {
+        memcpy(ptr[component[i]], self->vertex + i * 3, 3 * sizeof(vert_t));
+        ptr[component[i]] += 3;
+    }
+
+    release_vertex(self);
+    self->vertex_count = 0;
+    self->vertex = NULL;
+    self->geometry = NULL;
+    self->revision += 1;
+
+    PyObject * res = PyList_New(component_count);
+    for (int i = component_count - 1; i >= 0; --i) {
+        Mesh * mesh = meshes[i];
+        mesh->parent = self;
+        mesh->slibling = self->child;
+        self->child = mesh;
+        set_scene(mesh, self->scene);
+        Py_INCREF(mesh);
+        PyList_SET_ITEM(res, i, (PyObject *)mesh);
+    }
+
+    PyMem_Free(indices);
+    PyMem_Free(parent);
+    PyMem_Free(label);
+    PyMem_Free(component);
+    PyMem_Free(size);
+    PyMem_Free(meshes);
+    PyMem_Free(ptr);
+    return res;
+}
+
+static PyObject * Mesh_meth_strip_degenerates(Mesh * self, PyObject * args) {
+    write_vertex(self);
+    const int count = strip_triangles(self->vertex, NULL, self->vertex_count);
+    const int removed = (self->vertex_count - count) / 3;
+    self->vertex_count = count;
+    return PyLong_FromLong(removed);
+}
+
+static inline vec_t sample_colormap(const vec_t * colors, float last, float f) {
+    f = f > 0.0f ? f : 0.0f;
+    f = f < last ? f : last;
+    const int idx = (int)f;
+    const int next = f < last ? idx + 1 : idx;
+    const float w = f - idx;
+    const vec_t & a = colors[idx];
+    const vec_t & b = colors[next];
+    return {a.x + (b.x - a.x) * w, a.y + (b.y - a.y) * w, a.z + (b.z - a.z) * w};
+}
+
+static PyObject * Mesh_meth_paint_by(Mesh * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"source", "colormap", "range", "recursive", NULL};
+
+    PyObject * source;
+    PyObject * colormap_arg = Py_None;
+    PyObject * range_arg = Py_None;
+    int recursive = false;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OOp", (char **)keywords, &source, &colormap_arg, &range_arg, &recursive)) {
+        return NULL;
+    }
+
+    const bool height = PyUnicode_Check(source) && !PyUnicode_CompareWithASCIIString(source, "height");
+    const bool normal = PyUnicode_Check(source) && !PyUnicode_CompareWithASCIIString(source, "normal");
+
+    if (PyUnicode_Check(source) && !height && !normal) {
+        PyErr_Format(PyExc_ValueError, "invalid source");
+        return NULL;
+    }
+
+    Mesh ** targets;
+    const int target_count = paint_targets(self, recursive, &targets);
+
+    int total_vertex_count = 0;
+    for (int k = 0; k < target_count; ++k) {
+        total_vertex_count += targets[k]->vertex_count;
+    }
+
+    if (normal) {
+        for (int k = 0; k < target_count; ++k) {
+            Mesh * mesh = targets[k];
+            write_vertex(mesh);
+            vert_t * vertex = mesh->vertex;
+            for (int i = 0; i < mesh->vertex_count; ++i) {
+                const vec_t & n = vertex[i].normal;
+                vertex[i].color = {n.x * 0.5f + 0.5f, n.y * 0.5f + 0.5f, n.z * 0.5f + 0.5f};
+            }
+        }
+        PyMem_Free(targets);
+        Py_RETURN_NONE;
+    }
+
+    Py_buffer values = {};
+    Py_buffer colormap = {};
+    const vec_t grayscale[] = {{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}};
+
+    if (!height && PyObject_GetBuffer(source, &values, PyBUF_SIMPLE)) {
+        PyMem_Free(targets);
+        return NULL;
+    }
+
+    if (colormap_arg != Py_None && PyObject_GetBuffer(colormap_arg, &colormap, PyBUF_SIMPLE)) {
+        PyBuffer_Release(&values);
+        PyMem_Free(targets);
+        return NULL;
+    }
+
+    const vec_t * colors = colormap.buf ? (vec_t *)colormap.buf : grayscale;
+    const int color_count = colormap.buf ? (int)(colormap.len / sizeof(vec_t)) : 2;
+
+    if ((values.buf && values.len != (Py_ssize_t)(total_vertex_count * sizeof(float))) || color_count < 1) {
+        PyErr_Format(PyExc_ValueError, "expected %d values and a non-empty colormap", total_vertex_count);
+        PyBuffer_Release(&values);
+        PyBuffer_Release(&colormap);
+        PyMem_Free(targets);
+        return NULL;
+    }
+
+    float lo = INFINITY;
+    float hi = -INFINITY;
+
+    if (range_arg != Py_None) {
+        if (!PyArg_ParseTuple(range_arg, "ff", &lo, &hi)) {
+            PyBuffer_Release(&values);
+            PyBuffer_Release(&colormap);
+            PyMem_Free(targets);
+            return NULL;
+        }
+    } else if (values.buf) {
+        const float * value = (float *)values.buf;
+        for (int i = 0; i < total_vertex_count; ++i) {
+            lo = value[i] < lo ? value[i] : lo;
+            hi = value[i] > hi ? value[i] : hi;
+        }
+    } else {
+        for (int k = 0; k < target_count; ++k) {
+            const vert_t * vertex = targets[k]->vertex;
+            for (int i = 0; i < targets[k]->vertex_count; ++i) {
+                lo = vertex[i].vertex.z < lo ? vertex[i].vertex.z : lo;
+                hi = vertex[i].vertex.z > hi ? vertex[i].vertex.z : hi;
+            }
+        }
+    }
+
+    const float scale = hi > lo ? (color_count - 1) / (hi - lo) : 0.0f;
+    const float last = (float)(color_count - 1);
+    const float * value = (float *)values.buf;
+
+    for (int k = 0; k < target_count; ++k) {
+        Mesh * mesh = targets[k];
+        write_vertex(mesh);
+        vert_t * vertex = mesh->vertex;
+        const int count = mesh->vertex_count;
+        if (value) {
+            for (int i = 0; i < count; ++i) {
+                vertex[i].color = sample_colormap(colors, last, (value[i] - lo) * scale);
+            }
+            value += count;
+        } else {
+            for (int i = 0; i < count; ++i) {
+                vertex[i].color = sample_colormap(colors, last, (vertex[i].vertex.z - lo) * scale);
+            }
+        }
+    }
+
+    PyBuffer_Release(&values);
+    PyBuffer_Release(&colormap);
+    PyMem_Free(targets);
+    Py_RETURN_NONE;
+}
+
+static PyObject * Scene_meth_add(Scene * self, PyObject * args, PyObject * kwargs) {
+    return Mesh_meth_add(self->base, args, kwargs);
+}
+
+static PyObject * Scene_meth_remove(Scene * self, PyObject * args, PyObject * kwargs) {
+    return Mesh_meth_remove(self->base, args, kwargs);
+}
+
+static PyObject * Scene_meth_clone(Scene * self, PyObject * args) {
+    Scene * res = meth_scene(NULL, NULL, NULL);
+    copy_children(self->base, res->base);
+    set_scene(res->base, res);
+    reserve_nodes(res, self->node_count);
+    res->node_count = self->node_count;
+    memcpy(res->node_parent, self->node_parent, self->node_count * sizeof(int));
+    memcpy(res->node_local, self->node_local, self->node_count * sizeof(trans_t));
+    memcpy(res->node_world, self->node_world, self->node_count * sizeof(trans_t));
+    memcpy(res->node_mesh, self->node_mesh, self->node_count * sizeof(Mesh *));
+    for (int i = 0; i < res->node_count; ++i) {
+        res->node_baked[i].offset = -1;
+        res->node_previous[i].valid = false;
+        Py_XINCREF(res->node_mesh[i]);
+    }
+    return (PyObject *)res;
+}
+
+static bool parse_handles(Scene * self, PyObject * handles, Py_buffer * view, int * count) {
+    if (handles == Py_None) {
+        *count = self->node_count;
+        return true;
+    }
+    if (PyObject_GetBuffer(handles, view, PyBUF_SIMPLE)) {
+        return false;
+    }
+    *count = (int)(view->len / sizeof(int));
+    const int * handle = (int *)view->buf;
+    for (int i = 0; i < *count; ++i) {
+        if (handle[i] < 0 || handle[i] >= self->node_count) {
+            PyErr_Format(PyExc_IndexError, "invalid handle %d", handle[i]);
+            PyBuffer_Release(view);
+            return false;
+        }
+    }
+    return true;
+}
+
+static PyObject * Scene_meth_create(Scene * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"mesh", "count", "parent", NULL};
+
+    PyObject * mesh = Py_None;
+    int count = 1;
+    int parent = -1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|Oii", (char **)keywords, &mesh, &count, &parent)) {
+        return NULL;
+    }
+
+    if (mesh != Py_None && Py_TYPE(mesh) != Mesh_type) {
+        PyErr_Format(PyExc_TypeError, "mesh must be a Mesh or None");
+        return NULL;
+    }
+
+    if (count < 0 || parent < -1 || parent >= self->node_count) {
+        PyErr_Format(PyExc_ValueError, "invalid count or parent");
+        return NULL;
+    }
+
+    if (parent >= 0 && !uniform_scale(self->node_local[parent].scale)) {
+        PyErr_Format(PyExc_ValueError, "cannot add children to a node with non-uniform scale");
+        return NULL;
+    }
+
+    int first = self->node_count;
+    reserve_nodes(self, first + count);
+    for (int i = first; i < first + count; ++i) {
+        self->node_parent[i] = parent;
+        self->node_local[i] = identity;
+        self->node_world[i] = identity;
+        self->node_mesh[i] = mesh != Py_None ? (Mesh *)mesh : NULL;
+        self->node_baked[i].offset = -1;
+        self->node_previous[i].valid = false;
+        Py_XINCREF(self->node_mesh[i]);
+    }
+    self->node_count += count;
+    return PyLong_FromLong(first);
+}
+
+static PyObject * read_nodes(Scene * self, PyObject * args, PyObject * kwargs, const void * table, int size) {
+    const char * keywords[] = {"handles", NULL};
+
+    PyObject * handles = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O", (char **)keywords, &handles)) {
+        return NULL;
+    }
+
+    Py_buffer view = {};
+    int count;
+
+    if (!parse_handles(self, handles, &view, &count)) {
+        return NULL;
+    }
+
+    PyObject * res = PyBytes_FromStringAndSize(NULL, count * size);
+    char * ptr = PyBytes_AsString(res);
+    for (int i = 0; i < count; ++i) {
+        const int index = view.buf ? ((int *)view.buf)[i] : i;
+        memcpy(ptr + i * size, (char *)table + index * size, size);
+    }
+
+    PyBuffer_Release(&view);
+    return res;
+}
+
+static PyObject * Scene_meth_get_transforms(Scene * self, PyObject * args, PyObject * kwargs) {
+    return read_nodes(self, args, kwargs, self->node_local, sizeof(trans_t));
+}
+
+static PyObject * Scene_meth_get_world_transforms(Scene * self, PyObject * args, PyObject * kwargs) {
+    return read_nodes(self, args, kwargs, self->node_world, sizeof(trans_t));
+}
+
+static PyObject * Scene_meth_get_parents(Scene * self, PyObject * args, PyObject * kwargs) {
+    return read_nodes(self, args, kwargs, self->node_parent, sizeof(int));
+}
+
+static PyObject * Scene_meth_set_transforms(Scene * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"data", "handles", NULL};
+
+    Py_buffer data = {};
+    PyObject * handles = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*|O", (char **)keywords, &data, &handles)) {
+        return NULL;
+    }
+
+    Py_buffer view = {};
+    int count;
+
+    if (!parse_handles(self, handles, &view, &count)) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+
+    const int data_count = (int)(data.len / sizeof(trans_t));
+    if (view.buf ? data_count != count : data_count > count) {
+        PyErr_Format(PyExc_ValueError, "data size does not match the handles");
+        PyBuffer_Release(&view);
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+
+    const trans_t * src = (trans_t *)data.buf;
+    char * has_children = NULL;
+    for (int i = 0; i < data_count; ++i) {
+        if (uniform_scale(src[i].scale)) {
+            continue;
+        }
+        if (!has_children) {
+            has_children = (char *)PyMem_Malloc(self->node_count + 1);
+            memset(has_children, 0, self->node_count);
+            for (int j = 0; j < self->node_count; ++j) {
+                if (self->node_parent[j] >= 0) {
+                    has_children[self->node_parent[j]] = 1;
+                }
+            }
+        }
+        const int index = view.buf ? ((int *)view.buf)[i] : i;
+        if (has_children[index]) {
+            PyErr_Format(PyExc_ValueError, "non-uniform scale is only supported on nodes without children, node %d has children", index);
+            PyMem_Free(has_children);
+            PyBuffer_Release(&view);
+            PyBuffer_Release(&data);
+            return NULL;
+        }
+    }
+    PyMem_Free(has_children);
+
+    for (int i = 0; i < data_count; ++i) {
+        const int index = view.buf ? ((int *)view.buf)[i] : i;
+        self->node_local[index] = src[i];
+    }
+
+    PyBuffer_Release(&view);
+    PyBuffer_Release(&data);
+    Py_RETURN_NONE;
+}
+
+static PyObject * Scene_meth_set_parents(Scene * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"data", "handles", NULL};
+
+    Py_buffer data = {};
+    PyObject * handles = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*|O", (char **)keywords, &data, &handles)) {
+        return NULL;
+    }
+
+    Py_buffer view = {};
+    int count;
+
+    if (!parse_handles(self, handles, &view, &count)) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+
+    const int data_count = (int)(data.len / sizeof(int));
+    if (view.buf ? data_count != count : data_count > count) {
+        PyErr_Format(PyExc_ValueError, "data size does not match the handles");
+        PyBuffer_Release(&view);
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+
+    const int * src = (int *)data.buf;
+    for (int i = 0; i < data_count; ++i) {
+        const int index = view.buf ? ((int *)view.buf)[i] : i;
+        if (src[i] < -1 || src[i] >= index) {
+            PyErr_Format(PyExc_ValueError, "the parent of node %d must be created before it", index);
+            PyBuffer_Release(&view);
+            PyBuffer_Release(&data);
+            return NULL;
+        }
+        if (src[i] >= 0 && !uniform_scale(self->node_local[src[i]].scale)) {
+            PyErr_Format(PyExc_ValueError, "cannot parent node %d to a node with non-uniform scale", index);
+            PyBuffer_Release(&view);
+            PyBuffer_Release(&data);
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i < data_count; ++i) {
+        const int index = view.buf ? ((int *)view.buf)[i] : i;
+        self->node_parent[index] = src[i];
+    }
+
+    PyBuffer_Release(&view);
+    PyBuffer_Release(&data);
+    Py_RETURN_NONE;
+}
+
+static void update_order(Scene * self) {
+    if (self->order_structure == self->structure) {
+        return;
+    }
+
+    int capacity = self->order_count > 64 ? self->order_count : 64;
+    int level_capacity = self->level_count > 16 ? self->level_count + 1 : 16;
+    Mesh ** order = (Mesh **)PyMem_Realloc(self->order, capacity * sizeof(Mesh *));
+    int * level = (int *)PyMem_Realloc(self->level, level_capacity * sizeof(int));
+    int level_count = 0;
+    int tail = 0;
+    level[0] = 0;
+    for (int head = -1; head < tail; ++head) {
+        if (head >= 0 && head == level[level_count]) {
+            if (level_count + 2 > level_capacity) {
+                level_capacity *= 2;
+                level = (int *)PyMem_Realloc(level, level_capacity * sizeof(int));
+            }
+            level[++level_count] = tail;
+        }
+        Mesh * parent = head < 0 ? self->base : order[head];
+        for (Mesh * child = parent->child; child; child = child->slibling) {
+            if (tail == capacity) {
+                capacity *= 2;
+                order = (Mesh **)PyMem_Realloc(order, capacity * sizeof(Mesh *));
+            }
+            order[tail++] = child;
+        }
+    }
+
+    self->order = order;
+    self->order_count = tail;
+    self->level = level;
+    self->level_count = level_count;
+    self->order_structure = self->structure;
+}
+
+static void update_transforms(Scene * self) {
+    update_order(self);
+
+    for (int i = 0; i < self->level_count; ++i) {
+        Mesh ** order = self->order + self->level[i];
+        parallel_for(self->level[i + 1] - self->level[i], 16384, [&](int begin, int end) {
+            for (int j = begin; j < end; ++j) {
+                Mesh * mesh = order[j];
+                const Mesh * parent = mesh->parent;
+                mesh->world_transform = apply_transform(parent->world_transform, mesh->local_transform);
+                mesh->world_position = transform_position(parent->world_transform, parent->world_position, mesh->position);
+            }
+        });
+    }
+
+    for (int i = 0; i < self->node_count; ++i) {
+        const int parent = self->node_parent[i];
+        const trans_t & t = parent < 0 ? self->base->world_transform : self->node_world[parent];
+        self->node_world[i] = apply_transform(t, self->node_local[i]);
+    }
+
+    self->transform_epoch = transform_epoch;
+}
+
+static void resolve_transforms(Scene * self) {
+    if (self->transform_epoch != transform_epoch) {
+        update_transforms(self);
+    }
+}
+
+static PyObject * Scene_meth_update_transforms(Scene * self, PyObject * args) {
+    update_transforms(self);
+    Py_RETURN_NONE;
+}
+
+static PyObject * Scene_meth_world_matrices(Scene * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"layout", "order", NULL};
+
+    const char * layout = "4x4";
+    const char * order = "row";
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|ss", (char **)keywords, &layout, &order)) {
+        return NULL;
+    }
+
+    const bool full = !strcmp(layout, "4x4");
+    const bool column = !strcmp(order, "column");
+
+    if ((!full && strcmp(layout, "3x4")) || (!column && strcmp(order, "row"))) {
+        PyErr_Format(PyExc_ValueError, "invalid layout or order");
+        return NULL;
+    }
+
+    resolve_transforms(self);
+
+    Mesh ** nodes;
+    const int count = flatten(self->base, &nodes, NULL);
+    const int rows = full ? 4 : 3;
+
+    PyObject * res = PyBytes_FromStringAndSize(NULL, count * rows * 4 * sizeof(float));
+    float * ptr = (float *)PyBytes_AsString(res);
+
+    for (int i = 0; i < count; ++i) {
+        const trans_t & t = nodes[i]->world_transform;
+        const quat_t & q = t.rotation;
+        const vec_t & s = t.scale;
+        const float m[4][4] = {
+            {(1.0f - 2.0f * (q.y * q.y + q.z * q.z)) * s.x, 2.0f * (q.x * q.y - q.z * q.w) * s.y, 2.0f * (q.x * q.z + q.y * q.w) * s.z, t.position.x},
+            {2.0f * (q.x * q.y + q.z * q.w) * s.x, (1.0f - 2.0f * (q.x * q.x + q.z * q.z)) * s.y, 2.0f * (q.y * q.z - q.x * q.w) * s.z, t.position.y},
+            {2.0f * (q.x * q.z - q.y * q.w) * s.x, 2.0f * (q.y * q.z + q.x * q.w) * s.y, (1.0f - 2.0f * (q.x * q.x + q.y * q.y)) * s.z, t.position.z},
+            {0.0f, 0.0f, 0.0f, 1.0f},
+        };
+        if (column) {
+            for (int c = 0; c < 4; ++c) {
+                for (int r = 0; r < rows; ++r) {
+                    *ptr++ = m[r][c];
+                }
+            }
+        } else {
+            memcpy(ptr, m, rows * 4 * sizeof(float));
+            ptr += rows * 4;
+        }
+    }
+
+    PyMem_Free(nodes);
+    return res;
+}
+
+static PyObject * Scene_meth_integrate(Scene * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"dt", "gravity", "ground", "restitution", NULL};
+
+    float dt;
+    vec_t gravity = {0.0f, 0.0f, 0.0f};
+    PyObject * ground_arg = Py_None;
+    float restitution = 0.5f;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "f|(fff)Of", (char **)keywords, &dt, &gravity.x, &gravity.y, &gravity.z, &ground_arg, &restitution)) {
+        return NULL;
+    }
+
+    const bool collide = ground_arg != Py_None;
+    const double ground = collide ? PyFloat_AsDouble(ground_arg) : 0.0;
+    if (PyErr_Occurred()) {
+        return NULL;
+    }
+
+    update_order(self);
+
+    Mesh ** order = self->order;
+    parallel_for(self->order_count, 4096, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            Mesh * mesh = order[i];
+            if (mesh->emitter) {
+                step_emitter(mesh->emitter, dt, gravity);
+            }
+            if (!mesh->dynamic) {
+                continue;
+            }
+
+            vec_t & v = mesh->linear_velocity;
+            const vec_t & w = mesh->angular_velocity;
+            v = {v.x + gravity.x * dt, v.y + gravity.y * dt, v.z + gravity.z * dt};
+
+            dvec_t & p = mesh->position;
+            p = {p.x + v.x * dt, p.y + v.y * dt, p.z + v.z * dt};
+            if (collide && p.z < ground) {
+                p.z = ground;
+                if (v.z < 0.0f) {
+                    v.z = -v.z * restitution;
+                }
+            }
+            mesh->local_transform.position = {(float)p.x, (float)p.y, (float)p.z};
+
+            quat_t & q = mesh->local_transform.rotation;
+            const quat_t & dq = quatmul({w.x * dt * 0.5f, w.y * dt * 0.5f, w.z * dt * 0.5f, 0.0f}, q);
+            q = {q.x + dq.x, q.y + dq.y, q.z + dq.z, q.w + dq.w};
+            const float l = 1.0f / sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+            q = {q.x * l, q.y * l, q.z * l, q.w * l};
+        }
+    });
+
+    transform_epoch += 1;
+    Py_RETURN_NONE;
+}
+
+static PyObject * Scene_meth_get_velocities(Scene * self, PyObject * args) {
+    Mesh ** nodes;
+    const int count = flatten(self->base, &nodes, NULL);
+
+    PyObject * linear = PyBytes_FromStringAndSize(NULL, count * sizeof(vec_t));
+    PyObject * angular = PyBytes_FromStringAndSize(NULL, count * sizeof(vec_t));
+    vec_t * linear_ptr = (vec_t *)PyBytes_AsString(linear);
+    vec_t * angular_ptr = (vec_t *)PyBytes_AsString(angular);
+    for (int i = 0; i < count; ++i) {
+        linear_ptr[i] = nodes[i]->linear_velocity;
+        angular_ptr[i] = nodes[i]->angular_velocity;
+    }
+
+    PyMem_Free(nodes);
+    return Py_BuildValue("(NN)", linear, angular);
+}
+
+static PyObject * Scene_meth_set_velocities(Scene * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"linear", "angular", NULL};
+
+    Py_buffer linear = {};
+    Py_buffer angular = {};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*|y*", (char **)keywords, &linear, &angular)) {
+        return NULL;
+    }
+
+    Mesh ** nodes;
+    const int count = flatten(self->base, &nodes, NULL);
+
+    if (linear.len != (Py_ssize_t)(count * sizeof(vec_t)) || (angular.buf && angular.len != linear.len)) {
+        PyErr_Format(PyExc_ValueError, "expected %d velocities", count);
+        PyMem_Free(nodes);
+        PyBuffer_Release(&linear);
+        PyBuffer_Release(&angular);
+        return NULL;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        nodes[i]->linear_velocity = ((vec_t *)linear.buf)[i];
+        if (angular.buf) {
+            nodes[i]->angular_velocity = ((vec_t *)angular.buf)[i];
+        }
+    }
+
+    PyMem_Free(nodes);
+    PyBuffer_Release(&linear);
+    PyBuffer_Release(&angular);
+    Py_RETURN_NONE;
+}
+
+static PyObject * Scene_meth_nodes(Scene * self, PyObject * args) {
+    return node_list(self->base);
+}
+
+static PyObject * Scene_meth_node_table(Scene * self, PyObject * args) {
+    resolve_transforms(self);
+
+    Mesh ** nodes;
+    int * parents;
+    int count = flatten(self->base, &nodes, &parents);
+
+    PyObject * parent_bytes = PyBytes_FromStringAndSize((char *)parents, count * sizeof(int));
+    PyObject * vertex_count_bytes = PyBytes_FromStringAndSize(NULL, count * sizeof(int));
+    PyObject * local_bytes = PyBytes_FromStringAndSize(NULL, count * sizeof(trans_t));
+    PyObject * world_bytes = PyBytes_FromStringAndSize(NULL, count * sizeof(trans_t));
+    int * vertex_count = (int *)PyBytes_AsString(vertex_count_bytes);
+    trans_t * local_transform = (trans_t *)PyBytes_AsString(local_bytes);
+    trans_t * world_transform = (trans_t *)PyBytes_AsString(world_bytes);
+
+    for (int i = 0; i < count; ++i) {
+        vertex_count[i] = nodes[i]->vertex_count;
+        local_transform[i] = nodes[i]->local_transform;
+        world_transform[i] = nodes[i]->world_transform;
+    }
+
+    PyMem_Free(nodes);
+    PyMem_Free(parents);
+    return Py_BuildValue("(NNNN)", parent_bytes, vertex_count_bytes, local_bytes, world_bytes);
+}
+
+static PyObject * Scene_meth_find(Scene * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"name", NULL};
+
+    PyObject * name;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "U", (char **)keywords, &name)) {
+        return NULL;
+    }
+
+    PyObject * group = PyDict_GetItem(self->names, name);
+    PyObject * res = NULL;
+    Py_ssize_t pos = 0;
+    if (!group || !PyDict_Next(group, &pos, &res, NULL)) {
+        Py_RETURN_NONE;
+    }
+    Py_INCREF(res);
+    return res;
+}
+
+static PyObject * Scene_meth_find_all(Scene * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"tag", NULL};
+
+    PyObject * tag;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "U", (char **)keywords, &tag)) {
+        return NULL;
+    }
+
+    PyObject * group = PyDict_GetItem(self->tags, tag);
+    if (!group) {
+        return PyList_New(0);
+    }
+    return PySequence_List(group);
+}
+
+static void add_span(span_t ** spans, int * count, int offset, int size) {
+    if (*count && (*spans)[*count - 1].offset + (*spans)[*count - 1].size == offset) {
+        (*spans)[*count - 1].size += size;
+        return;
+    }
+    if (!*count || (*count >= 16 && !(*count & (*count - 1)))) {
+        *spans = (span_t *)PyMem_Realloc(*spans, (*count ? *count * 2 : 16) * sizeof(span_t));
+    }
+    (*spans)[(*count)++] = {offset, size};
+}
+
+static int compare_gaps(const void * a, const void * b) {
+    const span_t * x = (const span_t *)a;
+    const span_t * y = (const span_t *)b;
+    return x->size != y->size ? (x->size < y->size ? -1 : 1) : x->offset - y->offset;
+}
+
+static PyObject * merge_spans(span_t * spans, int count, int max_spans) {
+    int merges = count > max_spans ? count - max_spans : 0;
+    if (merges) {
+        span_t * gaps = (span_t *)PyMem_Malloc((count - 1) * sizeof(span_t));
+        for (int i = 0; i < count - 1; ++i) {
+            gaps[i] = {i, spans[i + 1].offset - spans[i].offset - spans[i].size};
+        }
+        qsort(gaps, count - 1, sizeof(span_t), compare_gaps);
+        for (int i = 0; i < merges; ++i) {
+            spans[gaps[i].offset].size = -1;
+        }
+        PyMem_Free(gaps);
+    }
+
+    PyObject * res = PyList_New(0);
+    for (int i = 0; i < count; ++i) {
+        int first = spans[i].offset;
+        while (spans[i].size < 0) {
+            ++i;
+        }
+        const int size = spans[i].offset + spans[i].size - first;
+        PyObject * span = Py_BuildValue("(nn)", (Py_ssize_t)first * sizeof(vert_t), (Py_ssize_t)size * sizeof(vert_t));
+        PyList_Append(res, span);
+        Py_DECREF(span);
+    }
+    return res;
+}
+
+static inline bool bake_changed(baked_t & baked, const trans_t & t, int offset, unsigned revision) {
+    if (baked.offset == offset && baked.revision == revision && !memcmp(&baked.transform, &t, sizeof(trans_t))) {
+        return false;
+    }
+    baked = {t, offset, revision};
+    return true;
+}
+
+struct bake_t {
+    unsigned layers;
+    dvec_t origin;
+    vert_t * start;
+    vert_t * ptr;
+    bool persistent;
+    bool full;
+    span_t * spans;
+    int span_count;
+    vec_t * velocity;
+    vec_t motion;
+    bool skip_degenerate;
+    bool meshlet;
+    meshlet_t * meshlets;
+    int meshlet_count;
+    int meshlet_capacity;
+    bool cull;
+    bool camera;
+    vec_t eye;
+    int plane_count;
+    plane_t planes[6];
+    bool strip;
+};
+
+static inline trans_t relative_transform(const trans_t & t, const dvec_t & position, const dvec_t & origin) {
+    return {
+        {(float)(position.x - origin.x), (float)(position.y - origin.y), (float)(position.z - origin.z)},
+        t.rotation,
+        t.scale,
+    };
+}
+
+static const geometry_t * mesh_strip(Mesh * mesh) {
+    if (!mesh->geometry) {
+        mesh->geometry = new_geometry();
+    }
+    geometry_t * geometry = mesh->geometry;
+    if (geometry->strip_count < 0) {
+        geometry->strip_count = stripify(mesh->vertex, mesh->vertex_count / 3, &geometry->strip);
+    }
+    return geometry;
+}
+
+static inline int baked_vertex_count(const bake_t & bake, Mesh * mesh) {
+    if (!bake.strip) {
+        return emitted_vertex_count(mesh);
+    }
+    const int strip_count = mesh_strip(mesh)->strip_count;
+    const int copies = mesh->emitter ? mesh->emitter->count : 1;
+    return strip_count ? (strip_count + 3) * copies : 0;
+}
+
+static inline Mesh * node_mesh(const Scene * self, int index, unsigned layers) {
+    Mesh * mesh = self->node_mesh[index];
+    return mesh && mesh->visible && (mesh->layers & layers) ? mesh : NULL;
+}
+
+static int prepare_bake(Scene * self, bake_t & bake) {
+    Mesh * stack[1024];
+    int stack_index;
+
+    stack_index = 0;
+    stack[0] = self->base->child;
+    int total_vertex_count = 0;
+    while (true) {
+        Mesh * mesh = stack[stack_index];
+        if (mesh) {
+            stack[stack_index] = mesh->slibling;
+            if (!mesh->visible || !(mesh->layers & bake.layers)) {
+                continue;
+            }
+            const Mesh * parent = mesh->parent;
+            mesh->world_transform = apply_transform(parent->world_transform, mesh->local_transform);
+            mesh->world_position = transform_position(parent->world_transform, parent->world_position, mesh->position);
+            total_vertex_count += baked_vertex_count(bake, mesh);
+            if (mesh->child) {
+                stack[++stack_index] = mesh->child;
+            }
+        } else {
+            --stack_index;
+            if (stack_index < 0) {
+                break;
+            }
+        }
+    }
+
+    for (int i = 0; i < self->node_count; ++i) {
+        const int parent = self->node_parent[i];
+        const trans_t & t = parent < 0 ? self->base->world_transform : self->node_world[parent];
+        self->node_world[i] = apply_transform(t, self->node_local[i]);
+        if (Mesh * mesh = node_mesh(self, i, bake.layers)) {
+            total_vertex_count += baked_vertex_count(bake, mesh);
+        }
+    }
+
+    return total_vertex_count;
+}
+
+static inline trans_t particle_transform(const emitter_t * emitter, int i, const trans_t & t, float inv_lifetime, vec_t & color) {
+    const float f = emitter->age[i] * inv_lifetime;
+    const float size = emitter->size[0] + (emitter->size[1] - emitter->size[0]) * f;
+    const vec_t & c0 = emitter->color[0];
+    const vec_t & c1 = emitter->color[1];
+    color = {c0.x + (c1.x - c0.x) * f, c0.y + (c1.y - c0.y) * f, c0.z + (c1.z - c0.z) * f};
+    return apply_transform(t, {emitter->position[i], {0.0f, 0.0f, 0.0f, 1.0f}, {size, size, size}});
+}
+
+static void bake_emitter(bake_t & bake, Mesh * mesh, const trans_t & t) {
+    const emitter_t * emitter = mesh->emitter;
+    const int offset = (int)(bake.ptr - bake.start);
+    const float inv_lifetime = 1.0f / emitter->lifetime;
+    vert_t * ptr = bake.ptr;
+    for (int i = 0; i < emitter->count; ++i) {
+        vec_t color;
+        const trans_t & p = particle_transform(emitter, i, t, inv_lifetime, color);
+        const bool uniform = uniform_scale(p.scale);
+        const vert_t * src = mesh->vertex;
+        int count = mesh->vertex_count;
+        while (count--) {
+            *ptr = uniform ? apply_transform(p, *src++) : apply_scaled_transform(p, *src++);
+            ptr->color = color;
+            ++ptr;
+        }
+        if (bake.velocity) {
+            const vec_t & s = emitter->speed[i];
+            const vec_t & r = rotate_vector(t.rotation, {s.x * t.scale.x, s.y * t.scale.y, s.z * t.scale.z});
+            const vec_t & m = bake.motion;
+            const vec_t v = {r.x * emitter->step + m.x, r.y * emitter->step + m.y, r.z * emitter->step + m.z};
+            for (int j = 0; j < mesh->vertex_count; ++j) {
+                *bake.velocity++ = v;
+            }
+        }
+    }
+    bake.ptr = ptr;
+    if (bake.persistent && ptr != bake.start + offset) {
+        add_span(&bake.spans, &bake.span_count, offset, (int)(ptr - bake.start) - offset);
+    }
+}
+
+static void bake_vertices(bake_t & bake, Mesh * mesh, const trans_t & t, baked_t & baked, previous_t & previous) {
+    const int offset = (int)(bake.ptr - bake.start);
+    const bool changed = !bake.persistent || bake_changed(baked, t, offset, mesh->revision) || bake.full;
+    const bool uniform = uniform_scale(t.scale);
+    vert_t * ptr = bake.ptr;
+    vert_t * src = mesh->vertex;
+    int count = mesh->vertex_count;
+    if (bake.velocity && !previous.valid) {
+        if (changed) {
+            for (int i = 0; i < count; ++i) {
+                ptr[i] = uniform ? apply_transform(t, src[i]) : apply_scaled_transform(t, src[i]);
+            }
+        }
+        memset(bake.velocity, 0, count * sizeof(vec_t));
+        bake.velocity += count;
+        ptr += count;
+        previous = {t, true};
+    } else if (bake.velocity) {
+        const trans_t & p = previous.transform;
+        const vec_t & m = bake.motion;
+        vec_t * velocity = bake.velocity;
+        while (count--) {
+            const vec_t & q = transform_vertex(p, src->vertex);
+            if (changed) {
+                *ptr = uniform ? apply_transform(t, *src) : apply_scaled_transform(t, *src);
+            }
+            const vec_t & v = ptr->vertex;
+            *velocity++ = {v.x - q.x + m.x, v.y - q.y + m.y, v.z - q.z + m.z};
+            ++ptr;
+            ++src;
+        }
+        bake.velocity = velocity;
+        previous = {t, true};
+    } else if (!changed) {
+        ptr += count;
+    } else if (uniform) {
+        while (count--) {
+            *ptr++ = apply_transform(t, *src++);
+        }
+    } else {
+        while (count--) {
+            *ptr++ = apply_scaled_transform(t, *src++);
+        }
+    }
+    bake.ptr = ptr;
+    if (changed && bake.persistent && mesh->vertex_count) {
+        add_span(&bake.spans, &bake.span_count, offset, mesh->vertex_count);
+    }
+}
+
+static void bake_meshlets(bake_t & bake, Mesh * mesh, const trans_t & t, int offset) {
+    const geometry_t * geometry = mesh->geometry;
+    if (!geometry || !geometry->meshlet_count) {
+        return;
+    }
+    if (bake.meshlet_count + geometry->meshlet_count > bake.meshlet_capacity) {
+        while (bake.meshlet_count + geometry->meshlet_count > bake.meshlet_capacity) {
+            bake.meshlet_capacity = bake.meshlet_capacity ? bake.meshlet_capacity * 2 : 64;
+        }
+        bake.meshlets = (meshlet_t *)PyMem_Realloc(bake.meshlets, bake.meshlet_capacity * sizeof(meshlet_t));
+    }
+    const bool uniform = uniform_scale(t.scale);
+    const float scale = fmaxf(fabsf(t.scale.x), fmaxf(fabsf(t.scale.y), fabsf(t.scale.z)));
+    meshlet_t * ptr = bake.meshlets + bake.meshlet_count;
+    for (int i = 0; i < geometry->meshlet_count; ++i) {
+        const meshlet_t & m = geometry->meshlet[i];
+        *ptr = m;
+        ptr->center = transform_vertex(t, m.center);
+        ptr->radius = m.radius * scale;
+        if (uniform && t.scale.x > 0.0f && m.cone_cutoff < 1.0f) {
+            ptr->cone_axis = rotate_vector(t.rotation, m.cone_axis);
+        } else {
+            ptr->cone_axis = {0.0f, 0.0f, 0.0f};
+            ptr->cone_cutoff = 1.0f;
+        }
+        ptr->first_triangle = offset / 3 + m.first_triangle;
+        ++ptr;
+    }
+    bake.meshlet_count += geometry->meshlet_count;
+}
+
+static const geometry_t * mesh_clusters(Mesh * mesh) {
+    if (!mesh->geometry) {
+        mesh->geometry = new_geometry();
+    }
+    geometry_t * geometry = mesh->geometry;
+    const int triangle_count = mesh->vertex_count / 3;
+    if (geometry->meshlet_count || geometry->cluster_count || !triangle_count) {
+        return geometry;
+    }
+    const int cluster_count = (triangle_count + 63) / 64;
+    geometry->cluster = (meshlet_t *)PyMem_Malloc(cluster_count * sizeof(meshlet_t));
+    geometry->cluster_count = cluster_count;
+    for (int i = 0; i < cluster_count; ++i) {
+        const int first = i * 64;
+        geometry->cluster[i].first_triangle = first;
+        geometry->cluster[i].triangle_count = triangle_count - first < 64 ? triangle_count - first : 64;
+        meshlet_bounds(mesh->vertex, geometry->cluster[i]);
+    }
+    return geometry;
+}
+
+static inline bool cluster_culled(const bake_t & bake, const trans_t & t, const meshlet_t & cluster, bool uniform, float scale) {
+    const vec_t center = transform_vertex(t, cluster.center);
+    const float radius = cluster.radius * scale;
+    for (int i = 0; i < bake.plane_count; ++i) {
+        const plane_t & p = bake.planes[i];
+        if (p.normal.x * center.x + p.normal.y * center.y + p.normal.z * center.z + p.offset < -radius) {
+            return true;
+        }
+    }
+    if (bake.camera && uniform && t.scale.x > 0.0f && cluster.cone_cutoff < 1.0f) {
+        const vec_t axis = rotate_vector(t.rotation, cluster.cone_axis);
+        const vec_t d = {center.x - bake.eye.x, center.y - bake.eye.y, center.z - bake.eye.z};
+        const float length = sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+        if (d.x * axis.x + d.y * axis.y + d.z * axis.z >= cluster.cone_cutoff * length + radius) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void bake_clusters(bake_t & bake, Mesh * mesh, const trans_t & t, previous_t & previous) {
+    const geometry_t * geometry = mesh_clusters(mesh);
+    const bool meshlet = geometry->meshlet_count != 0;
+    const meshlet_t * cluster = meshlet ? geometry->meshlet : geometry->cluster;
+    const int cluster_count = meshlet ? geometry->meshlet_count : geometry->cluster_count;
+    const bool uniform = uniform_scale(t.scale);
+    const float scale = fmaxf(fabsf(t.scale.x), fmaxf(fabsf(t.scale.y), fabsf(t.scale.z)));
+    const trans_t & p = previous.transform;
+    const vec_t & m = bake.motion;
+    vert_t * ptr = bake.ptr;
+    for (int i = 0; i < cluster_count; ++i) {
+        if (cluster_culled(bake, t, cluster[i], uniform, scale)) {
+            continue;
+        }
+        const vert_t * src = mesh->vertex + cluster[i].first_triangle * 3;
+        int count = cluster[i].triangle_count * 3;
+        if (bake.velocity) {
+            vec_t * velocity = bake.velocity;
+            while (count--) {
+                *ptr = uniform ? apply_transform(t, *src) : apply_scaled_transform(t, *src);
+                if (previous.valid) {
+                    const vec_t & q = transform_vertex(p, src->vertex);
+                    const vec_t & v = ptr->vertex;
+                    *velocity = {v.x - q.x + m.x, v.y - q.y + m.y, v.z - q.z + m.z};
+                } else {
+                    *velocity = {0.0f, 0.0f, 0.0f};
+                }
+                ++velocity;
+                ++ptr;
+                ++src;
+            }
+            bake.velocity = velocity;
+        } else if (uniform) {
+            while (count--) {
+                *ptr++ = apply_transform(t, *src++);
+            }
+        } else {
+            while (count--) {
+                *ptr++ = apply_scaled_transform(t, *src++);
+            }
+        }
+    }
+    if (bake.velocity) {
+        previous = {t, true};
+    }
+    bake.ptr = ptr;
+}
+
+static void write_strip(bake_t & bake, const Mesh * mesh, const geometry_t * geometry, const trans_t & t, const vec_t * color) {
+    const bool uniform = uniform_scale(t.scale);
+    const vert_t * src = mesh->vertex;
+    const int * strip = geometry->strip;
+    vert_t * ptr = bake.ptr;
+    vert_t first = uniform ? apply_transform(t, src[strip[0]]) : apply_scaled_transform(t, src[strip[0]]);
+    if (color) {
+        first.color = *color;
+    }
+    if (ptr != bake.start) {
+        const bool odd = (ptr - bake.start) & 1;
+        const vert_t last = ptr[-1];
+        *ptr++ = last;
+        *ptr++ = first;
+        if (odd) {
+            *ptr++ = first;
+        }
+    }
+    for (int i = 0; i < geometry->strip_count; ++i) {
+        *ptr = uniform ? apply_transform(t, src[strip[i]]) : apply_scaled_transform(t, src[strip[i]]);
+        if (color) {
+            ptr->color = *color;
+        }
+        ++ptr;
+    }
+    bake.ptr = ptr;
+}
+
+static void bake_strip(bake_t & bake, Mesh * mesh, const trans_t & t) {
+    const geometry_t * geometry = mesh_strip(mesh);
+    if (!geometry->strip_count) {
+        return;
+    }
+    if (!mesh->emitter) {
+        write_strip(bake, mesh, geometry, t, NULL);
+        return;
+    }
+    const emitter_t * emitter = mesh->emitter;
+    const float inv_lifetime = 1.0f / emitter->lifetime;
+    for (int i = 0; i < emitter->count; ++i) {
+        vec_t color;
+        write_strip(bake, mesh, geometry, particle_transform(emitter, i, t, inv_lifetime, color), &color);
+    }
+}
+
+static void bake_mesh(bake_t & bake, Mesh * mesh, const trans_t & t, baked_t & baked, previous_t & previous) {
+    vert_t * begin = bake.ptr;
+    vec_t * velocity = bake.velocity;
+    if (bake.strip) {
+        bake_strip(bake, mesh, t);
+    } else if (mesh->emitter) {
+        bake_emitter(bake, mesh, t);
+    } else if (bake.cull) {
+        bake_clusters(bake, mesh, t, previous);
+    } else {
+        bake_vertices(bake, mesh, t, baked, previous);
+        if (bake.meshlet) {
+            bake_meshlets(bake, mesh, t, (int)(begin - bake.start));
+        }
+    }
+    if (bake.skip_degenerate) {
+        const int count = strip_triangles(begin, velocity, (int)(bake.ptr - begin));
+        bake.ptr = begin + count;
+        if (velocity) {
+            bake.velocity = velocity + count;
+        }
+    }
+}
+
+static void write_bake(Scene * self, bake_t & bake) {
+    Mesh * stack[1024];
+    int stack_index;
+
+    stack_index = 0;
+    stack[0] = self->base->child;
+    while (true) {
+        Mesh * mesh = stack[stack_index];
+        if (mesh) {
+            stack[stack_index] = mesh->slibling;
+            if (!mesh->visible || !(mesh->layers & bake.layers)) {
+                continue;
+            }
+            const trans_t & t = relative_transform(mesh->world_transform, mesh->world_position, bake.origin);
+            bake_mesh(bake, mesh, t, mesh->baked, mesh->previous);
+            if (mesh->child) {
+                stack[++stack_index] = mesh->child;
+            }
+        } else {
+            --stack_index;
+            if (stack_index < 0) {
+                break;
+            }
+        }
+    }
+
+    for (int i = 0; i < self->node_count; ++i) {
+        if (Mesh * mesh = node_mesh(self, i, bake.layers)) {
+            const trans_t & t = self->node_world[i];
+            const dvec_t p = {t.position.x, t.position.y, t.position.z};
+            bake_mesh(bake, mesh, relative_transform(t, p, bake.origin), self->node_baked[i], self->node_previous[i]);
+        }
+    }
+}
+
+static PyObject * Scene_meth_bake(Scene * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"layers", "out", "max_spans", "origin", "velocity", "skip_degenerate", "meshlets", "camera", "frustum", "topology", NULL};
+
+    bake_t bake = {0xffffffff};
+    PyObject * out = Py_None;
+    int max_spans = 16;
+    int velocity = false;
+    int skip_degenerate = false;
+    int meshlets = false;
+    PyObject * camera = Py_None;
+    PyObject * frustum = Py_None;
+    const char * topology = "triangles";
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|IOi(ddd)pppOOs", (char **)keywords, &bake.layers, &out, &max_spans, &bake.origin.x, &bake.origin.y, &bake.origin.z, &velocity, &skip_degenerate, &meshlets, &camera, &frustum, &topology)) {
+        return NULL;
+    }
+
+    if (camera != Py_None) {
+        if (!PyArg_ParseTuple(camera, "fff", &bake.eye.x, &bake.eye.y, &bake.eye.z)) {
+            return NULL;
+        }
+        bake.camera = true;
+    }
+
+    if (frustum != Py_None) {
+        PyObject * planes = PySequence_Fast(frustum, "frustum must be a sequence of planes");
+        if (!planes) {
+            return NULL;
+        }
+        const int plane_count = (int)PySequence_Fast_GET_SIZE(planes);
+        if (plane_count > 6) {
+            PyErr_Format(PyExc_ValueError, "frustum must have at most 6 planes");
+            Py_DECREF(planes);
+            return NULL;
+        }
+        for (int i = 0; i < plane_count; ++i) {
+            plane_t & p = bake.planes[i];
+            if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(planes, i), "ffff", &p.normal.x, &p.normal.y, &p.normal.z, &p.offset)) {
+                Py_DECREF(planes);
+                return NULL;
+            }
+        }
+        bake.plane_count = plane_count;
+        Py_DECREF(planes);
+    }
+
+    bake.cull = bake.camera || bake.plane_count;
+
+    if (out != Py_None && bake.cull) {
+        PyErr_Format(PyExc_ValueError, "camera and frustum cannot be used with out");
+        return NULL;
+    }
+
+    if (meshlets && bake.cull) {
+        PyErr_Format(PyExc_ValueError, "camera and frustum cannot be used with meshlets");
+        return NULL;
+    }
+
+    if (!strcmp(topology, "strip")) {
+        bake.strip = true;
+    } else if (strcmp(topology, "triangles")) {
+        PyErr_Format(PyExc_ValueError, "invalid topology %s", topology);
+        return NULL;
+    }
+
+    if (bake.strip && (out != Py_None || velocity || skip_degenerate || meshlets || bake.cull)) {
+        PyErr_Format(PyExc_ValueError, "strip topology cannot be used with out, velocity, skip_degenerate, meshlets, camera or frustum");
+        return NULL;
+    }
+
+    if (out != Py_None && skip_degenerate) {
+        PyErr_Format(PyExc_ValueError, "skip_degenerate cannot be used with out");
+        return NULL;
+    }
+
+    if (meshlets && skip_degenerate) {
+        PyErr_Format(PyExc_ValueError, "skip_degenerate cannot be used with meshlets");
+        return NULL;
+    }
+
+    bake.skip_degenerate = skip_degenerate;
+    bake.meshlet = meshlets;
+
+    if (max_spans < 1) {
+        max_spans = 1;
+    }
+
+    const int total_vertex_count = prepare_bake(self, bake);
+
+    PyObject * res = NULL;
+    Py_buffer view = {};
+
+    if (out != Py_None) {
+        if (PyObject_GetBuffer(out, &view, PyBUF_WRITABLE)) {
+            return NULL;
+        }
+        if (view.len < (Py_ssize_t)(total_vertex_count * sizeof(vert_t))) {
+            PyErr_Format(PyExc_ValueError, "out is too small, %d bytes required", (int)(total_vertex_count * sizeof(vert_t)));
+            PyBuffer_Release(&view);
+            return NULL;
+        }
+        bake.start = (vert_t *)view.buf;
+        bake.persistent = true;
+        bake.full = out != self->baked_object || view.buf != self->baked_buffer || view.len != self->baked_size;
+        Py_INCREF(out);
+        Py_XSETREF(self->baked_object, out);
+        self->baked_buffer = view.buf;
+        self->baked_size = view.len;
+    } else {
+        res = PyBytes_FromStringAndSize(NULL, total_vertex_count * sizeof(vert_t));
+        bake.start = (vert_t *)PyBytes_AsString(res);
+    }
+
+    PyObject * velocity_bytes = NULL;
+
+    if (velocity) {
+        velocity_bytes = PyBytes_FromStringAndSize(NULL, total_vertex_count * sizeof(vec_t));
+        bake.velocity = (vec_t *)PyBytes_AsString(velocity_bytes);
+        if (!self->previous_valid) {
+            self->previous_origin = bake.origin;
+            self->previous_valid = true;
+        }
+        bake.motion = {
+            (float)(bake.origin.x - self->previous_origin.x),
+            (float)(bake.origin.y - self->previous_origin.y),
+            (float)(bake.origin.z - self->previous_origin.z),
+        };
+        self->previous_origin = bake.origin;
+    }
+
+    bake.ptr = bake.start;
+    write_bake(self, bake);
+
+    if (bake.skip_degenerate || bake.cull || bake.strip) {
+        const int vertex_count = (int)(bake.ptr - bake.start);
+        _PyBytes_Resize(&res, vertex_count * sizeof(vert_t));
+        if (velocity_bytes) {
+            _PyBytes_Resize(&velocity_bytes, vertex_count * sizeof(vec_t));
+        }
+    }
+
+    if (view.buf) {
+        res = merge_spans(bake.spans, bake.span_count, max_spans);
+        PyMem_Free(bake.spans);
+        PyBuffer_Release(&view);
+    }
+
+    if (bake.meshlet) {
+        PyObject * meshlet_bytes = PyBytes_FromStringAndSize((char *)bake.meshlets, bake.meshlet_count * sizeof(meshlet_t));
+        PyMem_Free(bake.meshlets);
+        if (velocity_bytes) {
+            return Py_BuildValue("(NNN)", res, velocity_bytes, meshlet_bytes);
+        }
+        return Py_BuildValue("(NN)", res, meshlet_bytes);
+    }
+
+    if (velocity_bytes) {
+        return Py_BuildValue("(NN)", res, velocity_bytes);
+    }
+
+    return res;
+}
+
+static bool same_objects(const object_key_t * a, const object_key_t * b, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (a[i].id != b[i].id || a[i].revision != b[i].revision) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void add_object(object_key_t ** keys, trans_t ** transforms, int * count, Mesh * mesh, const trans_t & t) {
+    if (!mesh || !mesh->vertex_count || mesh->emitter) {
+        return;
+    }
+    if (!*count || (*count >= 64 && !(*count & (*count - 1)))) {
+        const int capacity = *count ? *count * 2 : 64;
+        *keys = (object_key_t *)PyMem_Realloc(*keys, capacity * sizeof(object_key_t));
+        *transforms = (trans_t *)PyMem_Realloc(*transforms, capacity * sizeof(trans_t));
+    }
+    (*keys)[*count] = {mesh, mesh->id, mesh->revision};
+    (*transforms)[*count] = t;
+    *count += 1;
+}
+
+static PyObject * Scene_meth_bake_objects(Scene * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"layers", "origin", NULL};
+
+    bake_t bake = {0xffffffff};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|I(ddd)", (char **)keywords, &bake.layers, &bake.origin.x, &bake.origin.y, &bake.origin.z)) {
+        return NULL;
+    }
+
+    prepare_bake(self, bake);
+
+    object_key_t * keys = NULL;
+    trans_t * transforms = NULL;
+    int count = 0;
+
+    Mesh * stack[1024];
+    int stack_index;
+
+    stack_index = 0;
+    stack[0] = self->base->child;
+    while (true) {
+        Mesh * mesh = stack[stack_index];
+        if (mesh) {
+            stack[stack_index] = mesh->slibling;
+            if (!mesh->visible || !(mesh->layers & bake.layers)) {
+                continue;
+            }
+            const trans_t & t = relative_transform(mesh->world_transform, mesh->world_position, bake.origin);
+            add_object(&keys, &transforms, &count, mesh, t);
+            if (mesh->child) {
+                stack[++stack_index] = mesh->child;
+            }
+        } else {
+            --stack_index;
+            if (stack_index < 0) {
+                break;
+            }
+        }
+    }
+
+    for (int i = 0; i < self->node_count; ++i) {
+        const trans_t & t = self->node_world[i];
+        const dvec_t p = {t.position.x, t.position.y, t.position.z};
+        add_object(&keys, &transforms, &count, node_mesh(self, i, bake.layers), relative_transform(t, p, bake.origin));
+    }
+
+    if (!self->objects || count != self->object_count || !same_objects(keys, self->object_keys, count)) {
+        int total_vertex_count = 0;
+        for (int i = 0; i < count; ++i) {
+            total_vertex_count += keys[i].mesh->vertex_count;
+        }
+        Py_XDECREF(self->objects);
+        self->objects = PyBytes_FromStringAndSize(NULL, total_vertex_count * sizeof(object_vert_t));
+        object_vert_t * ptr = (object_vert_t *)PyBytes_AsString(self->objects);
+        for (int i = 0; i < count; ++i) {
+            const vert_t * src = keys[i].mesh->vertex;
+            int vertex_count = keys[i].mesh->vertex_count;
+            while (vertex_count--) {
+                *ptr++ = {*src++, i};
+            }
+        }
+        PyMem_Free(self->object_keys);
+        self->object_keys = keys;
+        self->object_count = count;
+    } else {
+        PyMem_Free(keys);
+    }
+
+    PyObject * res = PyBytes_FromStringAndSize((char *)transforms, count * sizeof(trans_t));
+    PyMem_Free(transforms);
+    Py_INCREF(self->objects);
+    return Py_BuildValue("(NN)", self->objects, res);
+}
+
+static inline bool axis_separates(const vec_t & axis, const vec_t & a, const vec_t & b, const vec_t & c, float h) {
+    const float p0 = a.x * axis.x + a.y * axis.y + a.z * axis.z;
+    const float p1 = b.x * axis.x + b.y * axis.y + b.z * axis.z;
+    const float p2 = c.x * axis.x + c.y * axis.y + c.z * axis.z;
+    const float r = h * (fabsf(axis.x) + fabsf(axis.y) + fabsf(axis.z));
+    return fminf(p0, fminf(p1, p2)) > r || fmaxf(p0, fmaxf(p1, p2)) < -r;
+}
+
+static bool triangle_box(const vec_t & center, float h, const vec_t & p0, const vec_t & p1, const vec_t & p2) {
+    const vec_t a = {p0.x - center.x, p0.y - center.y, p0.z - center.z};
+    const vec_t b = {p1.x - center.x, p1.y - center.y, p1.z - center.z};
+    const vec_t c = {p2.x - center.x, p2.y - center.y, p2.z - center.z};
+    const vec_t e[3] = {
+        {b.x - a.x, b.y - a.y, b.z - a.z},
+        {c.x - b.x, c.y - b.y, c.z - b.z},
+        {a.x - c.x, a.y - c.y, a.z - c.z},
+    };
+    for (int i = 0; i < 3; ++i) {
+        if (axis_separates({0.0f, -e[i].z, e[i].y}, a, b, c, h)) {
+            return false;
+        }
+        if (axis_separates({e[i].z, 0.0f, -e[i].x}, a, b, c, h)) {
+            return false;
+        }
+        if (axis_separates({-e[i].y, e[i].x, 0.0f}, a, b, c, h)) {
+            return false;
+        }
+    }
+    if (axis_separates({1.0f, 0.0f, 0.0f}, a, b, c, h) || axis_separates({0.0f, 1.0f, 0.0f}, a, b, c, h) || axis_separates({0.0f, 0.0f, 1.0f}, a, b, c, h)) {
+        return false;
+    }
+    const vec_t n = {e[0].y * e[1].z - e[0].z * e[1].y, e[0].z * e[1].x - e[0].x * e[1].z, e[0].x * e[1].y - e[0].y * e[1].x};
+    const float d = n.x * a.x + n.y * a.y + n.z * a.z;
+    return fabsf(d) <= h * (fabsf(n.x) + fabsf(n.y) + fabsf(n.z));
+}
+
+static inline bool top_left(float du, float dv) {
+    return dv > 0.0f || (dv == 0.0f && du < 0.0f);
+}
+
+static int compare_floats(const void * a, const void * b) {
+    const float x = *(const float *)a;
+    const float y = *(const float *)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static inline int grid_size(float extent, float voxel_size) {
+    const float n = ceilf(extent / voxel_size);
+    return n > 1.0f ? (int)fminf(n, 2147483647.0f) : 1;
+}
+
+static inline int clamp_cell(float x, int n) {
+    return x < 0.0f ? 0 : x >= (float)n ? n - 1 : (int)x;
+}
+
+static PyObject * Scene_meth_voxelize(Scene * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"voxel_size", "bounds", "layers", "fill", NULL};
+
+    float voxel_size;
+    PyObject * bounds = Py_None;
+    bake_t bake = {0xffffffff};
+    int fill = true;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "f|OIp", (char **)keywords, &voxel_size, &bounds, &bake.layers, &fill)) {
+        return NULL;
+    }
+
+    if (!(voxel_size > 0.0f)) {
+        PyErr_Format(PyExc_ValueError, "voxel_size must be positive");
+        return NULL;
+    }
+
+    vec_t lo = {0.0f, 0.0f, 0.0f};
+    vec_t hi = {0.0f, 0.0f, 0.0f};
+    if (bounds != Py_None && !PyArg_ParseTuple(bounds, "(fff)(fff)", &lo.x, &lo.y, &lo.z, &hi.x, &hi.y, &hi.z)) {
+        return NULL;
+    }
+
+    const int total_vertex_count = prepare_bake(self, bake);
+    vert_t * vertex = (vert_t *)PyMem_Malloc(total_vertex_count * sizeof(vert_t));
+    bake.start = vertex;
+    bake.ptr = vertex;
+    write_bake(self, bake);
+    const int triangle_count = (int)(bake.ptr - bake.start) / 3;
+
+    if (bounds == Py_None && triangle_count) {
+        lo = vertex[0].vertex;
+        hi = vertex[0].vertex;
+        for (int i = 1; i < triangle_count * 3; ++i) {
+            const vec_t & v = vertex[i].vertex;
+            lo = {fminf(lo.x, v.x), fminf(lo.y, v.y), fminf(lo.z, v.z)};
+            hi = {fmaxf(hi.x, v.x), fmaxf(hi.y, v.y), fmaxf(hi.z, v.z)};
+        }
+    }
+
+    const int nx = grid_size(hi.x - lo.x, voxel_size);
+    const int ny = grid_size(hi.y - lo.y, voxel_size);
+    const int nz = grid_size(hi.z - lo.z, voxel_size);
+    const long long voxel_count = (long long)nx * ny * nz;
+
+    if (voxel_count > 2147483647ll || (long long)ny * nz > 268435455ll) {
+        PyErr_Format(PyExc_ValueError, "voxel grid is too large");
+        PyMem_Free(vertex);
+        return NULL;
+    }
+    const float inv = 1.0f / voxel_size;
+    const float h = voxel_size * 0.5f;
+
+    PyObject * res = PyBytes_FromStringAndSize(NULL, (voxel_count + 7) / 8);
+    unsigned char * bits = (unsigned char *)PyBytes_AsString(res);
+    memset(bits, 0, (voxel_count + 7) / 8);
+
+    const int row_count = ny * nz;
+    int * offset = NULL;
+    int * cursor = NULL;
+    float * crossing = NULL;
+    if (fill) {
+        offset = (int *)PyMem_Malloc((row_count + 1) * sizeof(int));
+        memset(offset, 0, (row_count + 1) * sizeof(int));
+    }
+
+    auto scan_crossings = [&](int z_begin, int z_end, bool gather) {
+        for (int t = 0; t < triangle_count; ++t) {
+            vec_t a = vertex[t * 3 + 0].vertex;
+            vec_t b = vertex[t * 3 + 1].vertex;
+            const vec_t & c = vertex[t * 3 + 2].vertex;
+            float area = (b.y - a.y) * (c.z - a.z) - (b.z - a.z) * (c.y - a.y);
+            if (area == 0.0f) {
+                continue;
+            }
+            if (area < 0.0f) {
+                const vec_t tmp = a;
+                a = b;
+                b = tmp;
+                area = -area;
+            }
+            const int y0 = clamp_cell((fminf(a.y, fminf(b.y, c.y)) - lo.y) * inv - 0.5f, ny);
+            const int y1 = clamp_cell((fmaxf(a.y, fmaxf(b.y, c.y)) - lo.y) * inv + 0.5f, ny);
+            const int z0 = clamp_cell((fminf(a.z, fminf(b.z, c.z)) - lo.z) * inv - 0.5f, nz);
+            const int z1 = clamp_cell((fmaxf(a.z, fmaxf(b.z, c.z)) - lo.z) * inv + 0.5f, nz);
+            for (int z = z0 < z_begin ? z_begin : z0; z <= z1 && z < z_end; ++z) {
+                for (int y = y0; y <= y1; ++y) {
+                    const float py = lo.y + (y + 0.5f) * voxel_size;
+                    const float pz = lo.z + (z + 0.5f) * voxel_size;
+                    const float w0 = (c.y - b.y) * (pz - b.z) - (c.z - b.z) * (py - b.y);
+                    const float w1 = (a.y - c.y) * (pz - c.z) - (a.z - c.z) * (py - c.y);
+                    const float w2 = (b.y - a.y) * (pz - a.z) - (b.z - a.z) * (py - a.y);
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+                        continue;
+                    }
+                    if ((w0 == 0.0f && !top_left(c.y - b.y, c.z - b.z)) || (w1 == 0.0f && !top_left(a.y - c.y, a.z - c.z)) || (w2 == 0.0f && !top_left(b.y - a.y, b.z - a.z))) {
+                        continue;
+                    }
+                    const int row = y + ny * z;
+                    if (gather) {
+                        crossing[cursor[row]++] = (w0 * a.x + w1 * b.x + w2 * c.x) / (w0 + w1 + w2);
+                    } else {
+                        offset[row + 1] += 1;
+                    }
+                }
+            }
+        }
+    };
+
+    const int slab_count = (nz + 7) / 8;
+    const int slab_grain = (int)(1 + 262144 / ((long long)nx * ny * 8));
+
+    parallel_for(slab_count, slab_grain, [&](int begin, int end) {
+        const int z_begin = begin * 8;
+        const int z_end = end * 8 < nz ? end * 8 : nz;
+        for (int t = 0; t < triangle_count; ++t) {
+            const vec_t & a = vertex[t * 3 + 0].vertex;
+            const vec_t & b = vertex[t * 3 + 1].vertex;
+            const vec_t & c = vertex[t * 3 + 2].vertex;
+            const vec_t tmin = {fminf(a.x, fminf(b.x, c.x)), fminf(a.y, fminf(b.y, c.y)), fminf(a.z, fminf(b.z, c.z))};
+            const vec_t tmax = {fmaxf(a.x, fmaxf(b.x, c.x)), fmaxf(a.y, fmaxf(b.y, c.y)), fmaxf(a.z, fmaxf(b.z, c.z))};
+            if (tmax.x < lo.x || tmax.y < lo.y || tmax.z < lo.z || tmin.x > lo.x + nx * voxel_size || tmin.y > lo.y + ny * voxel_size || tmin.z > lo.z + nz * voxel_size) {
+                continue;
+            }
+            const int x0 = clamp_cell((tmin.x - lo.x) * inv, nx);
+            const int x1 = clamp_cell((tmax.x - lo.x) * inv, nx);
+            const int y0 = clamp_cell((tmin.y - lo.y) * inv, ny);
+            const int y1 = clamp_cell((tmax.y - lo.y) * inv, ny);
+            const int z0 = clamp_cell((tmin.z - lo.z) * inv, nz);
+            const int z1 = clamp_cell((tmax.z - lo.z) * inv, nz);
+            for (int z = z0 < z_begin ? z_begin : z0; z <= z1 && z < z_end; ++z) {
+                for (int y = y0; y <= y1; ++y) {
+                    for (int x = x0; x <= x1; ++x) {
+                        const vec_t center = {lo.x + (x + 0.5f) * voxel_size, lo.y + (y + 0.5f) * voxel_size, lo.z + (z + 0.5f) * voxel_size};
+                        if (triangle_box(center, h, a, b, c)) {
+                            const long long index = x + (long long)nx * (y + (long long)ny * z);
+                            bits[index >> 3] |= 1 << (index & 7);
+                        }
+                    }
+                }
+            }
+        }
+        if (fill) {
+            scan_crossings(z_begin, z_end, false);
+        }
+    });
+
+    if (fill) {
+        for (int i = 0; i < row_count; ++i) {
+            offset[i + 1] += offset[i];
+        }
+        cursor = (int *)PyMem_Malloc(row_count * sizeof(int));
+        memcpy(cursor, offset, row_count * sizeof(int));
+        crossing = (float *)PyMem_Malloc((offset[row_count] + 1) * sizeof(float));
+
+        parallel_for(slab_count, slab_grain, [&](int begin, int end) {
+            const int z_begin = begin * 8;
+            const int z_end = end * 8 < nz ? end * 8 : nz;
+            scan_crossings(z_begin, z_end, true);
+            for (int row = z_begin * ny; row < z_end * ny; ++row) {
+                float * xs = crossing + offset[row];
+                const int count = offset[row + 1] - offset[row];
+                qsort(xs, count, sizeof(float), compare_floats);
+                for (int i = 0; i + 1 < count; i += 2) {
+                    const int x0 = (int)ceilf((xs[i] - lo.x) * inv - 0.5f);
+                    const int x1 = (int)floorf((xs[i + 1] - lo.x) * inv - 0.5f);
+                    for (int x = x0 < 0 ? 0 : x0; x <= x1 && x < nx; ++x) {
+                        const long long index = x + (long long)nx * row;
+                        bits[index >> 3] |= 1 << (index & 7);
+                    }
+                }
+            }
+        });
+
+        PyMem_Free(cursor);
+        PyMem_Free(crossing);
+    }
+    PyMem_Free(offset);
+
+    PyMem_Free(vertex);
+    return Py_BuildValue("(N(iii)(fff))", res, nx, ny, nz, lo.x, lo.y, lo.z);
+}
+
+static PyObject * meth_bake_many(PyObject * self, PyObject * args, PyObject * kwargs) {
+    const char * keywords[] = {"scenes", "layers", NULL};
+
+    PyObject * scenes;
+    bake_t bake = {0xffffffff};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|I", (char **)keywords, &scenes, &bake.layers)) {
+        return NULL;
+    }
+
+    PyObject * seq = PySequence_Fast(scenes, "scenes must be a sequence");
+    if (!seq) {
+        return NULL;
+    }
+
+    const int scene_count = (int)PySequence_Fast_GET_SIZE(seq);
+    PyObject ** scene_array = PySequence_Fast_ITEMS(seq);
+    for (int i = 0; i < scene_count; ++i) {
+        if (Py_TYPE(scene_array[i]) != Scene_type) {
+            PyErr_Format(PyExc_TypeError, "scenes must contain Scene objects");
+            Py_DECREF(seq);
+            return NULL;
+        }
+    }
+
+    PyObject * offsets = PyList_New(scene_count);
+    int * first = (int *)PyMem_Malloc((scene_count + 1) * sizeof(int));
+    first[0] = 0;
+    for (int i = 0; i < scene_count; ++i) {
+        PyList_SET_ITEM(offsets, i, PyLong_FromSsize_t(first[i] * sizeof(vert_t)));
+        first[i + 1] = first[i] + prepare_bake((Scene *)scene_array[i], bake);
+    }
+
+    const int total_vertex_count = first[scene_count];
+    PyObject * res = PyBytes_FromStringAndSize(NULL, total_vertex_count * sizeof(vert_t));
+    vert_t * start = (vert_t *)PyBytes_AsString(res);
+
+    const int workers = worker_count(total_vertex_count, 65536);
+    parallel_run(workers, [&](int worker) {
+        const int lo = (int)((long long)total_vertex_count * worker / workers);
+        const int hi = (int)((long long)total_vertex_count * (worker + 1) / workers);
+        for (int i = 0; i < scene_count; ++i) {
+            if (first[i] == first[i + 1] || first[i] < lo || first[i] >= hi) {
+                continue;
+            }
+            bake_t local = bake;
+            local.start = start + first[i];
+            local.ptr = local.start;
+            write_bake((Scene *)scene_array[i], local);
+        }
+    });
+
+    PyMem_Free(first);
+    Py_DECREF(seq);
+    return Py_BuildValue("(NN)", res, offsets);
+}
+
+static PyObject * vector_tuple(PyObject * value, int size) {
+    if (!value) {
+        PyErr_Format(PyExc_TypeError, "cannot delete attribute");
+        return NULL;
+    }
+    PyObject * tup = PySequence_Check(value) ? PySequence_Tuple(value) : NULL;
+    if (!tup || PyTuple_GET_SIZE(tup) != size) {
+        Py_XDECREF(tup);
+        PyErr_Format(PyExc_TypeError, "expected a sequence of %d floats", size);
+        return NULL;
+    }
+    return tup;
+}
+
+PyObject * Mesh_get_position(Mesh * self, void * closure) {
+    const dvec_t & p = self->position;
+    return Py_BuildValue("(ddd)", p.x, p.y, p.z);
+}
+
+int Mesh_set_position(Mesh * self, PyObject * value, void * closure) {
+    PyObject * tup = vector_tuple(value, 3);
+    if (!tup) {
+        return -1;
+    }
+    self->position = {
+        PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 0)),
+        PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 1)),
+        PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 2)),
+    };
+    self->local_transform.position = {(float)self->position.x, (float)self->position.y, (float)self->position.z};
+    Py_DECREF(tup);
+    transform_epoch += 1;
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+static void resolve_world(Mesh * mesh) {
+    if (mesh->scene && mesh->scene->transform_epoch == transform_epoch) {
+        return;
+    }
+    if (!mesh->parent) {
+        mesh->world_transform = mesh->local_transform;
+        mesh->world_position = mesh->position;
+        return;
+    }
+    const Mesh * parent = mesh->parent;
+    resolve_world(mesh->parent);
+    mesh->world_transform = apply_transform(parent->world_transform, mesh->local_transform);
+    mesh->world_position = transform_position(parent->world_transform, parent->world_position, mesh->position);
+}
+
+PyObject * Mesh_get_world_position(Mesh * self, void * closure) {
+    resolve_world(self);
+    const dvec_t & p = self->world_position;
+    return Py_BuildValue("(ddd)", p.x, p.y, p.z);
+}
+
+PyObject * Mesh_get_rotation(Mesh * self, void * closure) {
+    const quat_t & q = self->local_transform.rotation;
     return Py_BuildValue("(ffff)", q.x, q.y, q.z, q.w);
 }
 
 int Mesh_set_rotation(Mesh * self, PyObject * value, void * closure) {
-    PyObject * tup = PySequence_Tuple(value);
+    PyObject * tup = vector_tuple(value, 4);
+    if (!tup) {
+        return -1;
+    }
     self->local_transform.rotation = {
         (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 0)),
         (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 1)),
@@ -594,41 +4027,310 @@ int Mesh_set_rotation(Mesh * self, PyObject * value, void * closure) {
         (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 3)),
     };
     Py_DECREF(tup);
-    return 0;
+    transform_epoch += 1;
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+static PyObject * scale_value(const vec_t & s) {
+    if (uniform_scale(s)) {
+        return PyFloat_FromDouble(s.x);
+    }
+    return Py_BuildValue("(fff)", s.x, s.y, s.z);
 }
 
 PyObject * Mesh_get_scale(Mesh * self, void * closure) {
-    return PyFloat_FromDouble(self->local_transform.scale);
+    return scale_value(self->local_transform.scale);
 }
 
 int Mesh_set_scale(Mesh * self, PyObject * value, void * closure) {
-    self->local_transform.scale = (float)PyFloat_AsDouble(value);
+    vec_t scale;
+    if (value && PySequence_Check(value)) {
+        PyObject * tup = vector_tuple(value, 3);
+        if (!tup) {
+            return -1;
+        }
+        scale = {
+            (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 0)),
+            (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 1)),
+            (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 2)),
+        };
+        Py_DECREF(tup);
+    } else if (value) {
+        const float s = (float)PyFloat_AsDouble(value);
+        scale = {s, s, s};
+    } else {
+        PyErr_Format(PyExc_TypeError, "cannot delete attribute");
+        return -1;
+    }
+    if (PyErr_Occurred()) {
+        return -1;
+    }
+    if (!uniform_scale(scale) && self->child) {
+        PyErr_Format(PyExc_ValueError, "non-uniform scale is only supported on meshes without children");
+        return -1;
+    }
+    self->local_transform.scale = scale;
+    transform_epoch += 1;
     return 0;
 }
 
-PyObject * Mesh_get_world_transform(Mesh * self, void * closure) {
-    trans_t t = self->local_transform;
-    Mesh * ptr = self;
-    while (ptr->parent) {
-        t = apply_transform(ptr->parent->local_transform, t);
-        ptr = ptr->parent;
+PyObject * Mesh_get_name(Mesh * self, void * closure) {
+    Py_INCREF(self->name);
+    return self->name;
+}
+
+int Mesh_set_name(Mesh * self, PyObject * value, void * closure) {
+    if (!value || (value != Py_None && !PyUnicode_CheckExact(value))) {
+        PyErr_Format(PyExc_TypeError, "name must be a str or None");
+        return -1;
+    }
+    if (self->scene) {
+        unindex_mesh(self->scene, self);
+    }
+    Py_INCREF(value);
+    Py_SETREF(self->name, value);
+    if (self->scene) {
+        index_mesh(self->scene, self);
+    }
+    return 0;
+}
+
+PyObject * Mesh_get_tags(Mesh * self, void * closure) {
+    Py_INCREF(self->tags);
+    return self->tags;
+}
+
+int Mesh_set_tags(Mesh * self, PyObject * value, void * closure) {
+    PyObject * tup = value ? PySequence_Tuple(value) : NULL;
+    if (!tup) {
+        PyErr_Format(PyExc_TypeError, "tags must be a sequence of str");
+        return -1;
+    }
+    for (int i = 0; i < PyTuple_GET_SIZE(tup); ++i) {
+        if (!PyUnicode_CheckExact(PyTuple_GET_ITEM(tup, i))) {
+            Py_DECREF(tup);
+            PyErr_Format(PyExc_TypeError, "tags must be a sequence of str");
+            return -1;
+        }
+    }
+    if (self->scene) {
+        unindex_mesh(self->scene, self);
+    }
+    Py_SETREF(self->tags, tup);
+    if (self->scene) {
+        index_mesh(self->scene, self);
+    }
+    return 0;
+}
+
+PyObject * Mesh_get_visible(Mesh * self, void * closure) {
+    return PyBool_FromLong(self->visible);
+}
+
+int Mesh_set_visible(Mesh * self, PyObject * value, void * closure) {
+    const int flag = value ? PyObject_IsTrue(value) : -1;
+    if (flag < 0) {
+        if (!value) {
+            PyErr_Format(PyExc_TypeError, "cannot delete attribute");
+        }
+        return -1;
+    }
+    self->visible = flag;
+    return 0;
+}
+
+PyObject * Mesh_get_layers(Mesh * self, void * closure) {
+    return PyLong_FromUnsignedLong(self->layers);
+}
+
+int Mesh_set_layers(Mesh * self, PyObject * value, void * closure) {
+    if (!value) {
+        PyErr_Format(PyExc_TypeError, "cannot delete attribute");
+        return -1;
+    }
+    const unsigned long layers = PyLong_AsUnsignedLongMask(value);
+    if (PyErr_Occurred()) {
+        return -1;
+    }
+    self->layers = (unsigned)layers;
+    return 0;
+}
+
+PyObject * Mesh_get_dynamic(Mesh * self, void * closure) {
+    return PyBool_FromLong(self->dynamic);
+}
+
+int Mesh_set_dynamic(Mesh * self, PyObject * value, void * closure) {
+    const int flag = value ? PyObject_IsTrue(value) : -1;
+    if (flag < 0) {
+        if (!value) {
+            PyErr_Format(PyExc_TypeError, "cannot delete attribute");
+        }
+        return -1;
+    }
+    self->dynamic = flag;
+    return 0;
+}
+
+PyObject * Mesh_get_linear_velocity(Mesh * self, void * closure) {
+    const vec_t & v = self->linear_velocity;
+    return Py_BuildValue("(fff)", v.x, v.y, v.z);
+}
+
+int Mesh_set_linear_velocity(Mesh * self, PyObject * value, void * closure) {
+    PyObject * tup = vector_tuple(value, 3);
+    if (!tup) {
+        return -1;
+    }
+    self->linear_velocity = {
+        (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 0)),
+        (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 1)),
+        (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 2)),
+    };
+    Py_DECREF(tup);
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+PyObject * Mesh_get_angular_velocity(Mesh * self, void * closure) {
+    const vec_t & v = self->angular_velocity;
+    return Py_BuildValue("(fff)", v.x, v.y, v.z);
+}
+
+int Mesh_set_angular_velocity(Mesh * self, PyObject * value, void * closure) {
+    PyObject * tup = vector_tuple(value, 3);
+    if (!tup) {
+        return -1;
+    }
+    self->angular_velocity = {
+        (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 0)),
+        (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 1)),
+        (float)PyFloat_AsDouble(PyTuple_GET_ITEM(tup, 2)),
+    };
+    Py_DECREF(tup);
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+PyObject * Mesh_get_particle_count(Mesh * self, void * closure) {
+    return PyLong_FromLong(self->emitter ? self->emitter->count : 0);
+}
+
+PyObject * Mesh_get_rate(Mesh * self, void * closure) {
+    return PyFloat_FromDouble(self->emitter ? self->emitter->rate : 0.0);
+}
+
+int Mesh_set_rate(Mesh * self, PyObject * value, void * closure) {
+    if (!self->emitter) {
+        PyErr_Format(PyExc_AttributeError, "mesh is not an emitter");
+        return -1;
+    }
+    if (!value) {
+        PyErr_Format(PyExc_TypeError, "cannot delete attribute");
+        return -1;
+    }
+    const double rate = PyFloat_AsDouble(value);
+    if (PyErr_Occurred()) {
+        return -1;
+    }
+    if (!(rate >= 0.0)) {
+        PyErr_Format(PyExc_ValueError, "rate must not be negative");
+        return -1;
+    }
+    self->emitter->rate = (float)rate;
+    return 0;
+}
+
+PyObject * Mesh_get_parent(Mesh * self, void * closure) {
+    if (!self->parent || (self->scene && self->parent == self->scene->base)) {
+        Py_RETURN_NONE;
+    }
+    Py_INCREF(self->parent);
+    return (PyObject *)self->parent;
+}
+
+PyObject * Mesh_get_children(Mesh * self, void * closure) {
+    PyObject * res = PyList_New(0);
+    for (Mesh * child = self->child; child; child = child->slibling) {
+        PyList_Append(res, (PyObject *)child);
     }
+    return res;
+}
+
+PyObject * Mesh_get_world_transform(Mesh * self, void * closure) {
+    resolve_world(self);
+    const trans_t & t = self->world_transform;
     const vec_t & p = t.position;
     const quat_t & r = t.rotation;
-    return Py_BuildValue("((fff)(ffff)f)", p.x, p.y, p.z, r.x, r.y, r.z, r.w, t.scale);
+    return Py_BuildValue("((fff)(ffff)N)", p.x, p.y, p.z, r.x, r.y, r.z, r.w, scale_value(t.scale));
 }
 
 PyObject * Mesh_get_mem(Mesh * self, void * closure) {
-    return PyMemoryView_FromMemory((char *)self->vertex, self->vertex_count * sizeof(vert_t), PyBUF_WRITE);
+    return PyMemoryView_FromObject((PyObject *)self);
+}
+
+static int Mesh_getbuffer(Mesh * self, Py_buffer * view, int flags) {
+    own_vertex(self);
+    if (PyBuffer_FillInfo(view, (PyObject *)self, self->vertex, self->vertex_count * sizeof(vert_t), 0, flags)) {
+        return -1;
+    }
+    self->exports += 1;
+    return 0;
+}
+
+static void Mesh_releasebuffer(Mesh * self, Py_buffer * view) {
+    self->exports -= 1;
+}
+
+static void Mesh_dealloc(Mesh * self) {
+    while (self->child) {
+        Mesh * child = self->child;
+        self->child = child->slibling;
+        child->parent = NULL;
+        child->slibling = NULL;
+        set_scene(child, NULL);
+        Py_DECREF(child);
+    }
+    Py_DECREF(self->name);
+    Py_DECREF(self->tags);
+    release_vertex(self);
+    release_emitter(self->emitter);
+    Py_TYPE(self)->tp_free(self);
 }
 
-static void default_dealloc(PyObject * self) {
+static void Scene_dealloc(Scene * self) {
+    set_scene(self->base, NULL);
+    Py_DECREF(self->base);
+    Py_DECREF(self->names);
+    Py_DECREF(self->tags);
+    for (int i = 0; i < self->node_count; ++i) {
+        Py_XDECREF(self->node_mesh[i]);
+    }
+    PyMem_Free(self->node_parent);
+    PyMem_Free(self->node_local);
+    PyMem_Free(self->node_world);
+    PyMem_Free(self->node_mesh);
+    PyMem_Free(self->node_baked);
+    PyMem_Free(self->node_previous);
+    PyMem_Free(self->order);
+    PyMem_Free(self->level);
+    Py_XDECREF(self->objects);
+    Py_XDECREF(self->baked_object);
+    PyMem_Free(self->object_keys);
     Py_TYPE(self)->tp_free(self);
 }
 
 static PyMethodDef Mesh_methods[] = {
+    {"touch", (PyCFunction)Mesh_meth_touch, METH_NOARGS},
     {"add", (PyCFunction)Mesh_meth_add, METH_VARARGS | METH_KEYWORDS},
+    {"remove", (PyCFunction)Mesh_meth_remove, METH_VARARGS | METH_KEYWORDS},
+    {"clone", (PyCFunction)Mesh_meth_clone, METH_VARARGS | METH_KEYWORDS},
+    {"descendants", (PyCFunction)Mesh_meth_descendants, METH_NOARGS},
     {"paint", (PyCFunction)Mesh_meth_paint, METH_VARARGS | METH_KEYWORDS},
+    {"paint_by", (PyCFunction)Mesh_meth_paint_by, METH_VARARGS | METH_KEYWORDS},
+    {"strip_degenerates", (PyCFunction)Mesh_meth_strip_degenerates, METH_NOARGS},
+    {"optimize", (PyCFunction)Mesh_meth_optimize, METH_VARARGS | METH_KEYWORDS},
+    {"build_meshlets", (PyCFunction)Mesh_meth_build_meshlets, METH_VARARGS | METH_KEYWORDS},
+    {"smooth", (PyCFunction)Mesh_meth_smooth, METH_VARARGS | METH_KEYWORDS},
+    {"split_components", (PyCFunction)Mesh_meth_split_components, METH_NOARGS},
     {},
 };
 
@@ -636,7 +4338,19 @@ static PyGetSetDef Mesh_getset[] = {
     {"position", (getter)Mesh_get_position, (setter)Mesh_set_position},
     {"rotation", (getter)Mesh_get_rotation, (setter)Mesh_set_rotation},
     {"scale", (getter)Mesh_get_scale, (setter)Mesh_set_scale},
+    {"name", (getter)Mesh_get_name, (setter)Mesh_set_name},
+    {"tags", (getter)Mesh_get_tags, (setter)Mesh_set_tags},
+    {"visible", (getter)Mesh_get_visible, (setter)Mesh_set_visible},
+    {"layers", (getter)Mesh_get_layers, (setter)Mesh_set_layers},
+    {"dynamic", (getter)Mesh_get_dynamic, (setter)Mesh_set_dynamic},
+    {"linear_velocity", (getter)Mesh_get_linear_velocity, (setter)Mesh_set_linear_velocity},
+    {"angular_velocity", (getter)Mesh_get_angular_velocity, (setter)Mesh_set_angular_velocity},
+    {"particle_count", (getter)Mesh_get_particle_count, NULL},
+    {"rate", (getter)Mesh_get_rate, (setter)Mesh_set_rate},
+    {"parent", (getter)Mesh_get_parent, NULL},
+    {"children", (getter)Mesh_get_children, NULL},
     {"world_transform", (getter)Mesh_get_world_transform, NULL},
+    {"world_position", (getter)Mesh_get_world_position, NULL},
     {"mem", (getter)Mesh_get_mem, NULL},
     {},
 };
@@ -644,19 +4358,40 @@ static PyGetSetDef Mesh_getset[] = {
 static PyType_Slot Mesh_slots[] = {
     {Py_tp_methods, Mesh_methods},
     {Py_tp_getset, Mesh_getset},
-    {Py_tp_dealloc, default_dealloc},
+    {Py_tp_dealloc, Mesh_dealloc},
+    {Py_bf_getbuffer, Mesh_getbuffer},
+    {Py_bf_releasebuffer, Mesh_releasebuffer},
     {},
 };
 
 static PyMethodDef Scene_methods[] = {
     {"add", (PyCFunction)Scene_meth_add, METH_VARARGS | METH_KEYWORDS},
+    {"remove", (PyCFunction)Scene_meth_remove, METH_VARARGS | METH_KEYWORDS},
+    {"clone", (PyCFunction)Scene_meth_clone, METH_NOARGS},
+    {"create", (PyCFunction)Scene_meth_create, METH_VARARGS | METH_KEYWORDS},
+    {"get_transforms", (PyCFunction)Scene_meth_get_transforms, METH_VARARGS | METH_KEYWORDS},
+    {"set_transforms", (PyCFunction)Scene_meth_set_transforms, METH_VARARGS | METH_KEYWORDS},
+    {"get_world_transforms", (PyCFunction)Scene_meth_get_world_transforms, METH_VARARGS | METH_KEYWORDS},
+    {"get_parents", (PyCFunction)Scene_meth_get_parents, METH_VARARGS | METH_KEYWORDS},
+    {"set_parents", (PyCFunction)Scene_meth_set_parents, METH_VARARGS | METH_KEYWORDS},
+    {"update_transforms", (PyCFunction)Scene_meth_update_transforms, METH_NOARGS},
+    {"integrate", (PyCFunction)Scene_meth_integrate, METH_VARARGS | METH_KEYWORDS},
+    {"get_velocities", (PyCFunction)Scene_meth_get_velocities, METH_NOARGS},
+    {"set_velocities", (PyCFunction)Scene_meth_set_velocities, METH_VARARGS | METH_KEYWORDS},
+    {"world_matrices", (PyCFunction)Scene_meth_world_matrices, METH_VARARGS | METH_KEYWORDS},
+    {"nodes", (PyCFunction)Scene_meth_nodes, METH_NOARGS},
+    {"node_table", (PyCFunction)Scene_meth_node_table, METH_NOARGS},
+    {"find", (PyCFunction)Scene_meth_find, METH_VARARGS | METH_KEYWORDS},
+    {"find_all", (PyCFunction)Scene_meth_find_all, METH_VARARGS | METH_KEYWORDS},
     {"bake", (PyCFunction)Scene_meth_bake, METH_VARARGS | METH_KEYWORDS},
+    {"bake_objects", (PyCFunction)Scene_meth_bake_objects, METH_VARARGS | METH_KEYWORDS},
+    {"voxelize", (PyCFunction)Scene_meth_voxelize, METH_VARARGS | METH_KEYWORDS},
     {},
 };
 
 static PyType_Slot Scene_slots[] = {
     {Py_tp_methods, Scene_methods},
-    {Py_tp_dealloc, default_dealloc},
+    {Py_tp_dealloc, Scene_dealloc},
     {},
 };
 
@@ -671,10 +4406,17 @@ static PyMethodDef module_methods[] = {
     {"uvsphere", (PyCFunction)meth_uvsphere, METH_VARARGS | METH_KEYWORDS},
     {"icosphere", (PyCFunction)meth_icosphere, METH_VARARGS | METH_KEYWORDS},
     {"mesh", (PyCFunction)meth_mesh, METH_VARARGS | METH_KEYWORDS},
+    {"emitter", (PyCFunction)meth_emitter, METH_VARARGS | METH_KEYWORDS},
     {"scene", (PyCFunction)meth_scene, METH_VARARGS | METH_KEYWORDS},
+    {"bake_many", (PyCFunction)meth_bake_many, METH_VARARGS | METH_KEYWORDS},
     {"random_rotation", (PyCFunction)meth_random_rotation, METH_FASTCALL},
     {"random_axis", (PyCFunction)meth_random_axis, METH_FASTCALL},
     {"euler", (PyCFunction)meth_euler, METH_VARARGS | METH_KEYWORDS},
+    {"quat_mul", (PyCFunction)meth_quat_mul, METH_VARARGS | METH_KEYWORDS},
+    {"quat_rotate", (PyCFunction)meth_quat_rotate, METH_VARARGS | METH_KEYWORDS},
+    {"quat_slerp", (PyCFunction)meth_quat_slerp, METH_VARARGS | METH_KEYWORDS},
+    {"quat_inverse", (PyCFunction)meth_quat_inverse, METH_VARARGS | METH_KEYWORDS},
+    {"transform_points", (PyCFunction)meth_transform_points, METH_VARARGS | METH_KEYWORDS},
     {},
 };
 